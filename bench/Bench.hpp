@@ -0,0 +1,48 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <cstdlib>
+#include <new>
+#include <time.h>
+
+/* What the benchmarks under bench/ share. Each benchmark is one program
+   built from its own .cpp, so this header is included once per binary.
+
+   Define BENCH_COUNT_ALLOCS before including it to replace the global
+   operator new/delete with versions that count every allocation (and its
+   size) in g_allocs/g_allocBytes. */
+
+static inline double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#ifdef BENCH_COUNT_ALLOCS
+
+static size_t g_allocs;
+static size_t g_allocBytes;
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+    ++g_allocs;
+    g_allocBytes += size;
+    void *p = std::malloc(size ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+// GCC 11+ cannot tell that operator new above is malloc() underneath
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) throw()
+{
+    std::free(p);
+}
+
+#endif
+
+#endif
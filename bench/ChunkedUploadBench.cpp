@@ -0,0 +1,152 @@
+#include "Bench.hpp"
+#include "HTTPparser.hpp"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+
+/* Benchmark: framing and decoding multi-megabyte chunked uploads that
+   arrive in recv()-sized pieces.
+
+   - rescan:  the framing the Client used to do, reconstructed: after every
+              recv() the buffer is searched for the end of the header section
+              and the whole chunked body for "\r\n0\r\n", then the complete
+              request is decoded in a second pass
+   - feed:    HTTPparser::feed() on every piece, as Client::readRequest()
+              does now (every byte looked at once)
+
+   The rescan variant is quadratic in the body size, so it only runs for
+   the smaller uploads. Both must decode the same number of body bytes.
+
+   Build and run with: make bench
+*/
+
+static std::string makeUpload(size_t bodySize, size_t chunkSize)
+{
+    std::string req = "POST /cgi-bin/upload.py HTTP/1.1\r\n"
+                      "Host: localhost:8080\r\n"
+                      "User-Agent: curl/7.88.1\r\n"
+                      "Content-Type: application/octet-stream\r\n"
+                      "Transfer-Encoding: chunked\r\n"
+                      "\r\n";
+    std::string chunk(chunkSize, 'x');
+    for (size_t i = 0; i < chunkSize; ++i)
+        chunk[i] = static_cast<char>(std::rand()); // may contain "\r\n0\r\n"
+    for (size_t sent = 0; sent < bodySize; sent += chunkSize)
+    {
+        size_t n = std::min(chunkSize, bodySize - sent);
+        std::ostringstream size;
+        size << std::hex << n << "\r\n";
+        req += size.str();
+        req.append(chunk, 0, n);
+        req += "\r\n";
+    }
+    req += "0\r\n\r\n";
+    return req;
+}
+
+// Decoded body size, 0 if the upload could not be framed
+static size_t frameRescan(const std::string &upload, size_t piece)
+{
+    std::string buffer;
+    size_t headerEnd = std::string::npos;
+    bool complete = false;
+    for (size_t pos = 0; pos < upload.size() && !complete; pos += piece)
+    {
+        buffer.append(upload, pos, piece);
+        headerEnd = buffer.find("\r\n\r\n");
+        if (headerEnd != std::string::npos)
+            complete = buffer.find("\r\n0\r\n", headerEnd) != std::string::npos &&
+                       buffer.compare(buffer.size() - 4, 4, "\r\n\r\n") == 0;
+    }
+    if (!complete)
+        return 0;
+
+    // Second pass: decode the chunks of the complete request
+    std::string body;
+    size_t pos = headerEnd + 4;
+    while (pos < buffer.size())
+    {
+        size_t eol = buffer.find("\r\n", pos);
+        size_t size = std::strtoul(buffer.substr(pos, eol - pos).c_str(), NULL, 16);
+        if (size == 0)
+            break;
+        body += buffer.substr(eol + 2, size);
+        pos = eol + 2 + size + 2;
+    }
+    return body.size();
+}
+
+static size_t frameFeed(HTTPparser &parser, const std::string &upload, size_t piece)
+{
+    parser.reset();
+    for (size_t pos = 0; pos < upload.size(); pos += piece)
+    {
+        size_t n = std::min(piece, upload.size() - pos);
+        HTTPparser::FeedResult res = parser.feed(upload.data() + pos, n);
+        if (res == HTTPparser::MESSAGE_COMPLETE)
+            return parser.getBody().size();
+        if (res == HTTPparser::FEED_ERROR)
+            return 0;
+    }
+    return 0;
+}
+
+static void report(const char *impl, double ns, size_t bytes)
+{
+    std::cout << "    " << std::left << std::setw(8) << impl << std::right << std::setw(10) << std::fixed
+              << std::setprecision(2) << ns / 1e6 << " ms/upload" << std::setw(9) << std::setprecision(0)
+              << bytes / (ns / 1e9) / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+int main()
+{
+    const size_t mb = 1024 * 1024;
+    const size_t bodySizes[] = {1 * mb, 8 * mb, 32 * mb};
+    const size_t chunkSizes[] = {4096, 64 * 1024};
+    const size_t piece = 64 * 1024; // bytes per recv()
+    const size_t rescanLimit = 8 * mb;
+    bool agree = true;
+    HTTPparser parser;
+
+    std::srand(42);
+    for (size_t b = 0; b < sizeof(bodySizes) / sizeof(bodySizes[0]); ++b)
+    {
+        for (size_t c = 0; c < sizeof(chunkSizes) / sizeof(chunkSizes[0]); ++c)
+        {
+            std::string upload = makeUpload(bodySizes[b], chunkSizes[c]);
+            std::cout << bodySizes[b] / mb << " MB body in " << chunkSizes[c] / 1024 << " KB chunks, "
+                      << piece / 1024 << " KB recv()s:" << std::endl;
+            size_t rounds = (64 * mb) / bodySizes[b];
+
+            size_t expected = frameFeed(parser, upload, piece);
+            agree = agree && expected == bodySizes[b];
+            if (bodySizes[b] <= rescanLimit)
+            {
+                size_t decoded = 0;
+                size_t rescanRounds = rounds / 8 + 1;
+                double t0 = nowNs();
+                for (size_t i = 0; i < rescanRounds; ++i)
+                    decoded = frameRescan(upload, piece);
+                report("rescan", (nowNs() - t0) / rescanRounds, bodySizes[b]);
+                agree = agree && decoded == expected;
+            }
+            else
+                std::cout << "    rescan  skipped (quadratic)" << std::endl;
+
+            double t0 = nowNs();
+            for (size_t i = 0; i < rounds; ++i)
+                agree = agree && frameFeed(parser, upload, piece) == expected;
+            report("feed", (nowNs() - t0) / rounds, bodySizes[b]);
+        }
+    }
+    if (!agree)
+    {
+        std::cerr << "decoded body sizes disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "Bench.hpp"
+#include "ConnectionTable.hpp"
+#include <map>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+/* Microbenchmark: std::map<int, Client *> (the old Reactor client table)
+   against ConnectionTable for the operations of the event loop hot path.
+   The Client pointers are fake and never dereferenced.
+
+   Build and run with: make bench
+*/
+
+static Client *fakeClient(int fd)
+{
+    return reinterpret_cast<Client *>(static_cast<size_t>(fd + 1) * 64);
+}
+
+// Keeps the compiler from dropping the measured loops
+static volatile size_t g_sink;
+
+static void report(const char *what, const char *impl, double ns, size_t ops)
+{
+    std::cout << "  " << std::left << std::setw(10) << what << std::setw(18) << impl
+              << std::right << std::setw(9) << std::fixed << std::setprecision(2) << ns / ops << " ns/op" << std::endl;
+}
+
+static void benchMap(const std::vector<int> &fds, const std::vector<int> &lookups, size_t passes)
+{
+    std::map<int, Client *> table;
+    double t0 = nowNs();
+    for (size_t i = 0; i < fds.size(); ++i)
+        table[fds[i]] = fakeClient(fds[i]);
+    report("insert", "std::map", nowNs() - t0, fds.size());
+
+    size_t sum = 0;
+    t0 = nowNs();
+    for (size_t i = 0; i < lookups.size(); ++i)
+    {
+        std::map<int, Client *>::iterator it = table.find(lookups[i]);
+        if (it != table.end())
+            sum += reinterpret_cast<size_t>(it->second);
+    }
+    report("lookup", "std::map", nowNs() - t0, lookups.size());
+
+    t0 = nowNs();
+    for (size_t p = 0; p < passes; ++p)
+        for (std::map<int, Client *>::iterator it = table.begin(); it != table.end(); ++it)
+            sum += reinterpret_cast<size_t>(it->second);
+    report("iterate", "std::map", nowNs() - t0, passes * table.size());
+
+    t0 = nowNs();
+    for (size_t i = 0; i < fds.size(); ++i)
+        table.erase(fds[i]);
+    report("erase", "std::map", nowNs() - t0, fds.size());
+    g_sink = sum;
+}
+
+static void benchTable(const std::vector<int> &fds, const std::vector<int> &lookups, size_t passes)
+{
+    ConnectionTable table;
+    double t0 = nowNs();
+    for (size_t i = 0; i < fds.size(); ++i)
+        table.insert(fds[i], fakeClient(fds[i]));
+    report("insert", "ConnectionTable", nowNs() - t0, fds.size());
+
+    size_t sum = 0;
+    t0 = nowNs();
+    for (size_t i = 0; i < lookups.size(); ++i)
+    {
+        Client *cl = table.find(lookups[i]);
+        if (cl != NULL)
+            sum += reinterpret_cast<size_t>(cl);
+    }
+    report("lookup", "ConnectionTable", nowNs() - t0, lookups.size());
+
+    t0 = nowNs();
+    for (size_t p = 0; p < passes; ++p)
+        for (size_t i = 0; i < table.size(); ++i)
+            sum += reinterpret_cast<size_t>(table.clientAt(i));
+    report("iterate", "ConnectionTable", nowNs() - t0, passes * table.size());
+
+    t0 = nowNs();
+    for (size_t i = 0; i < fds.size(); ++i)
+        table.erase(fds[i]);
+    report("erase", "ConnectionTable", nowNs() - t0, fds.size());
+    g_sink = sum;
+}
+
+int main()
+{
+    const size_t sizes[] = {1000, 10000, 50000, 100000};
+    std::srand(42);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t n = sizes[s];
+        // Descriptors as the kernel hands them out (lowest free first),
+        // inserted and erased in a shuffled order like real connections
+        std::vector<int> fds;
+        for (size_t i = 0; i < n; ++i)
+            fds.push_back(static_cast<int>(i) + 5);
+        for (size_t i = n - 1; i > 0; --i)
+            std::swap(fds[i], fds[std::rand() % (i + 1)]);
+        std::vector<int> lookups;
+        for (size_t i = 0; i < 1000000; ++i)
+            lookups.push_back(fds[std::rand() % n]);
+        size_t passes = 10000000 / n;
+
+        std::cout << n << " connections:" << std::endl;
+        benchMap(fds, lookups, passes);
+        benchTable(fds, lookups, passes);
+    }
+    return 0;
+}
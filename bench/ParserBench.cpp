@@ -0,0 +1,250 @@
+#define BENCH_COUNT_ALLOCS
+#include "Bench.hpp"
+#include "HTTPparser.hpp"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+/* Benchmark: whole requests through HTTPparser, the way a keep-alive
+   connection uses it (one parser, reset between requests).
+
+   - whole:  parseRequest() on the complete request
+   - recv:   feed() in 64 byte pieces and finish(), as a slow client or a
+             small TCP segment delivers it
+
+   Corpora: small GETs, browser-style header sets, chunked (and
+   Content-Length) uploads, malformed requests. Every request must be
+   accepted or rejected as listed, otherwise the benchmark fails.
+
+   Every operator new is counted, with its size. The allocations per
+   request are deterministic for a given standard library: a corpus that
+   needs more than its budget below fails the benchmark, so a regression
+   in the hot path shows up before timing noise could hide it.
+
+   Build and run with: make bench-parser
+*/
+
+struct Request
+{
+    std::string data;
+    bool valid;
+};
+
+struct Corpus
+{
+    const char *name;
+    std::vector<Request> requests;
+    double allocBudget; // Max allocations per request once the parser is warm
+};
+
+static void add(Corpus &corpus, const std::string &data, bool valid)
+{
+    Request r;
+    r.data = data;
+    r.valid = valid;
+    corpus.requests.push_back(r);
+}
+
+static std::string chunked(const std::string &head, size_t bodySize, size_t chunkSize)
+{
+    std::string req = head + "Transfer-Encoding: chunked\r\n\r\n";
+    for (size_t sent = 0; sent < bodySize; sent += chunkSize)
+    {
+        size_t n = bodySize - sent < chunkSize ? bodySize - sent : chunkSize;
+        std::ostringstream size;
+        size << std::hex << n << "\r\n";
+        req += size.str();
+        req.append(n, 'x');
+        req += "\r\n";
+    }
+    return req + "0\r\n\r\n";
+}
+
+static std::vector<Corpus> makeCorpora()
+{
+    std::vector<Corpus> corpora;
+    Corpus c;
+
+    c.name = "small GETs";
+    c.allocBudget = 0;
+    c.requests.clear();
+    add(c, "GET / HTTP/1.1\r\nHost: localhost:8080\r\n\r\n", true);
+    add(c, "GET /index.html HTTP/1.1\r\n"
+           "Host: localhost:8080\r\n"
+           "User-Agent: curl/7.88.1\r\n"
+           "Accept: */*\r\n"
+           "\r\n", true);
+    add(c, "GET /images/logo.png?v=20250913 HTTP/1.1\r\n"
+           "Host: localhost:8080\r\n"
+           "Connection: keep-alive\r\n"
+           "\r\n", true);
+    add(c, "HEAD /docs/a/./b/../c.html HTTP/1.0\r\nHost: localhost\r\n\r\n", true);
+    corpora.push_back(c);
+
+    c.name = "browser";
+    c.allocBudget = 0.5; // getHostName() copies "shop.example.com", past the SSO size
+    c.requests.clear();
+    add(c, "GET /images/logo.png?v=20250913 HTTP/1.1\r\n"
+           "Host: www.example.com\r\n"
+           "Connection: keep-alive\r\n"
+           "sec-ch-ua: \"Chromium\";v=\"128\", \"Not;A=Brand\";v=\"24\", \"Google Chrome\";v=\"128\"\r\n"
+           "sec-ch-ua-mobile: ?0\r\n"
+           "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/128.0.0.0 Safari/537.36\r\n"
+           "sec-ch-ua-platform: \"Linux\"\r\n"
+           "Accept: image/avif,image/webp,image/apng,image/svg+xml,image/*,*/*;q=0.8\r\n"
+           "Sec-Fetch-Site: same-origin\r\n"
+           "Sec-Fetch-Mode: no-cors\r\n"
+           "Sec-Fetch-Dest: image\r\n"
+           "Referer: https://www.example.com/products/category/shoes?page=2&sort=price\r\n"
+           "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+           "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+           "Cookie: session=3f1e5a7c9b2d4f6e8a0c1e3g5i7k9m1o; _ga=GA1.2.1234567890.1726220000; theme=dark\r\n"
+           "\r\n", true);
+    add(c, "GET /account/orders?page=3 HTTP/1.1\r\n"
+           "Host: shop.example.com\r\n"
+           "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64; rv:130.0) Gecko/20100101 Firefox/130.0\r\n"
+           "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+           "Accept-Language: de,en-US;q=0.7,en;q=0.3\r\n"
+           "Accept-Encoding: gzip, deflate, br\r\n"
+           "Connection: keep-alive\r\n"
+           "Upgrade-Insecure-Requests: 1\r\n"
+           "If-Modified-Since: Sat, 13 Sep 2025 10:00:00 GMT\r\n"
+           "If-None-Match: \"5f2a-1757757600\"\r\n"
+           "Cache-Control: max-age=0\r\n"
+           "\r\n", true);
+    corpora.push_back(c);
+
+    const std::string upload = "POST /cgi-bin/upload.py HTTP/1.1\r\n"
+                               "Host: localhost:8080\r\n"
+                               "User-Agent: curl/7.88.1\r\n"
+                               "Content-Type: application/octet-stream\r\n";
+    c.name = "uploads";
+    c.allocBudget = 0;
+    c.requests.clear();
+    add(c, chunked(upload, 4096, 512), true);
+    add(c, chunked(upload, 12000, 4096), true);
+    add(c, upload + "Content-Length: 2048\r\n\r\n" + std::string(2048, 'y'), true);
+    corpora.push_back(c);
+
+    c.name = "malformed";
+    c.allocBudget = 2; // the error messages
+    c.requests.clear();
+    add(c, "GET /index.html\r\nHost: localhost\r\n\r\n", false);
+    add(c, "GET /index.html HTTP/2.0\r\nHost: localhost\r\n\r\n", false);
+    add(c, "GET /../etc/passwd HTTP/1.1\r\nHost: localhost\r\n\r\n", false);
+    add(c, "GET /%zz HTTP/1.1\r\nHost: localhost\r\n\r\n", false);
+    add(c, "GET / HTTP/1.1\r\nHost localhost\r\n\r\n", false);
+    add(c, "GET / HTTP/1.1\r\nBad Name: x\r\n\r\n", false);
+    add(c, upload + "Transfer-Encoding: chunked\r\n\r\nzz\r\nabc\r\n0\r\n\r\n", false);
+    add(c, upload + "Content-Length: 100\r\n\r\nshort", false);
+    // Framing a proxy could read differently: request smuggling
+    add(c, upload + "Content-Length: abc\r\n\r\n", false);
+    add(c, upload + "Content-Length: -5\r\n\r\n", false);
+    add(c, upload + "Content-Length: 5\r\nContent-Length: 6\r\n\r\nhello!", false);
+    add(c, upload + "Transfer-Encoding: chunked, gzip\r\n\r\n0\r\n\r\n", false);
+    add(c, upload + "Transfer-Encoding: notchunked\r\n\r\n0\r\n\r\n", false);
+    add(c, upload + "Transfer-Encoding: chunked\r\nTransfer-Encoding: gzip\r\n\r\n0\r\n\r\n", false);
+    corpora.push_back(c);
+    return corpora;
+}
+
+static bool parseWhole(HTTPparser &parser, const std::string &request)
+{
+    return parser.parseRequest(request);
+}
+
+static bool parseRecv(HTTPparser &parser, const std::string &request)
+{
+    const size_t piece = 64;
+    parser.reset();
+    for (size_t pos = 0; pos < request.size(); pos += piece)
+    {
+        size_t n = request.size() - pos < piece ? request.size() - pos : piece;
+        HTTPparser::FeedResult res = parser.feed(request.data() + pos, n);
+        if (res == HTTPparser::MESSAGE_COMPLETE || res == HTTPparser::FEED_ERROR)
+            break;
+    }
+    return parser.finish();
+}
+
+typedef bool (*ParseFn)(HTTPparser &parser, const std::string &request);
+
+struct Result
+{
+    double ns;         // per request
+    double allocs;     // per request
+    double allocBytes; // per request
+    bool expected;     // every request accepted or rejected as listed
+};
+
+static Result measure(ParseFn fn, const Corpus &corpus)
+{
+    const size_t rounds = 50000;
+    const std::vector<Request> &requests = corpus.requests;
+    HTTPparser parser;
+    Result r;
+
+    // Warm-up: the parser keeps its buffers from one request to the next
+    r.expected = true;
+    for (size_t i = 0; i < requests.size(); ++i)
+        r.expected = r.expected && fn(parser, requests[i].data) == requests[i].valid;
+
+    size_t allocs = g_allocs;
+    size_t allocBytes = g_allocBytes;
+    double t0 = nowNs();
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        for (size_t i = 0; i < requests.size(); ++i)
+            fn(parser, requests[i].data);
+    }
+    double count = static_cast<double>(rounds * requests.size());
+    r.ns = (nowNs() - t0) / count;
+    r.allocs = (g_allocs - allocs) / count;
+    r.allocBytes = (g_allocBytes - allocBytes) / count;
+    return r;
+}
+
+static void report(const char *impl, const Result &r)
+{
+    std::cout << "    " << std::left << std::setw(6) << impl << std::right << std::setw(11) << std::fixed
+              << std::setprecision(0) << 1e9 / r.ns << " req/s" << std::setw(9) << std::setprecision(1)
+              << r.ns << " ns/req" << std::setw(7) << std::setprecision(2) << r.allocs << " allocs/req"
+              << std::setw(9) << std::setprecision(0) << r.allocBytes << " bytes/req" << std::endl;
+}
+
+int main()
+{
+    std::vector<Corpus> corpora = makeCorpora();
+    const char *names[] = {"whole", "recv"};
+    const ParseFn fns[] = {parseWhole, parseRecv};
+    bool ok = true;
+
+    for (size_t c = 0; c < corpora.size(); ++c)
+    {
+        size_t bytes = 0;
+        for (size_t i = 0; i < corpora[c].requests.size(); ++i)
+            bytes += corpora[c].requests[i].data.size();
+        std::cout << corpora[c].name << " (" << corpora[c].requests.size() << " requests, "
+                  << bytes / corpora[c].requests.size() << " bytes avg):" << std::endl;
+        for (size_t f = 0; f < sizeof(fns) / sizeof(fns[0]); ++f)
+        {
+            Result r = measure(fns[f], corpora[c]);
+            report(names[f], r);
+            if (!r.expected)
+            {
+                std::cerr << corpora[c].name << "/" << names[f] << ": request accepted or rejected wrongly"
+                          << std::endl;
+                ok = false;
+            }
+            if (r.allocs > corpora[c].allocBudget)
+            {
+                std::cerr << corpora[c].name << "/" << names[f] << ": " << r.allocs
+                          << " allocs/req over the budget of " << corpora[c].allocBudget << std::endl;
+                ok = false;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -20,13 +20,12 @@
 #include "HttpServer.hpp"
 
 #define CGI_BUFFER_SIZE 4096
-#define CGI_TIMEOUT 30
 
 class CGI
 {
 private:
 	std::map<std::string, std::string> env_;
-	std::string request_body_;
+	int body_fd_; // spooled request body (owned by the parser), -1 if in memory
 	std::string script_path_;
 	std::string interpreter_path_;
 	int pipe_in_[2];
@@ -37,9 +36,9 @@ private:
 	void setupEnvironment(const HTTPparser &request);
 	char **createEnvArray() const;
 	char **createArgsArray() const;
-	void setupPipes();
+	void setupPipes(bool needInput);
 	void closePipes();
-	static std::string numberToString(int number);
+	static std::string numberToString(size_t number);
 
 public:
 	CGI(const HTTPparser &request);
@@ -49,8 +48,9 @@ public:
 	int execute();
 	std::string readResponse();
 	void cleanup();
+	void releasePipes();
 
-	// getters
+	// getters; getInputFd() is -1 when stdin is the spooled body file
 	int getInputFd() const { return pipe_in_[1]; }
 	int getOutputFd() const { return pipe_out_[0]; }
 	pid_t getPid() const { return cgi_pid_; }
@@ -7,6 +7,20 @@
 // Forward declare to avoid circular dependencies
 class Response;
 
+// Buffers above this capacity are freed instead of recycled on reset()
+// and when a keep-alive connection goes idle
+#define CLIENT_BUFFER_KEEP (64 * 1024)
+
+// Request reads (Client::receive): the recv() size starts small and grows
+// while reads fill it; one wakeup reads at most CLIENT_READ_BUDGET bytes
+#define CLIENT_READ_CHUNK_MIN 4096
+#define CLIENT_READ_CHUNK_MAX (256 * 1024)
+#define CLIENT_READ_BUDGET (1024 * 1024)
+
+// Pipelined requests that are already received are answered into the same
+// output queue until this much is waiting to be sent
+#define CLIENT_PIPELINE_FLUSH (64 * 1024)
+
 // Defines the state of the client connection lifecycle
 enum ClientState
 {
@@ -21,21 +35,41 @@ enum ClientState
 class Client
 {
 public:
+    // What the server's event loop currently has registered for this client.
+    // Interest masks are only recomputed when getState() differs from state.
+    struct PollRegistration
+    {
+        ClientState state;
+        int cgiIn;
+        int cgiOut;
+
+        PollRegistration() : state(CLOSING), cgiIn(-1), cgiOut(-1) {}
+    };
+
     // Constructor & Destructor
-    Client(int fd, HttpServer &_server, size_t serverIndex, int serverPort);
+    explicit Client(const HttpServer &server);
     ~Client();
 
+    // Lifecycle of a pooled client (see ClientPool): open() binds it to an
+    // accepted socket, reset() drops all connection state but keeps buffers
+    void open(int fd, size_t serverIndex, int serverPort);
+    void reset();
+
     // Main handler method called by the server
     void handleConnection();
-    void checkCgiTimeout(); 
 
-    // Timeout handling
-    void updateLastActivityTime();
-    bool hasTimedOut() const;
+    // Timeout handling: the timer is (re-)armed for the current state, see
+    // armTimer(); handleTimeout() is called by the Reactor when it expires
+    void setTimerWheel(TimerWheel *wheel);
+    void armTimer();
+    void handleTimeout();
 
     // Getters for the server to manage select()
     int getSocket() const;
     ClientState getState() const;
+    // Waiting for a request that has not started yet (idle keep-alive or a
+    // fresh connection): safe to close on a graceful stop
+    bool isIdle() const { return _state == READING && _request_buffer.empty() && !_parser.hasStarted(); }
 
     // Getters for server context
     size_t getServerIndex() const { return _serverIndex; }
@@ -45,33 +79,46 @@ public:
     int getCgiInputFd() const { return _cgi_pipe_in[1]; }
     int getCgiOutputFd() const { return _cgi_pipe_out[0]; }
 
+    // Event-loop bookkeeping owned by the Reactor serving this client
+    PollRegistration &getPollRegistration() { return _poll; }
+    // Bytes read from the socket since the last call (per-wakeup stats)
+    size_t takeBytesRead();
+    void setEventLoop(EventLoop *loop) { _loop = loop; }
+    void setFileCache(OpenFileCache *files) { _files = files; }
+    void setContentCache(ContentCache *content) { _content = content; }
+
 private:
     // Private methods for internal logic
     void readRequest();
+    ssize_t receive();
+    void sizeForBody(size_t remaining);
+    bool feedParser(size_t start);
     void generateResponse();
+    void queueResponse();
+    void nextRequest();
     void writeResponse();
-    size_t checkContentLength(const std::string &request, size_t header_end);
+    void responseSent();
 
     // non-blocking CGI helpers
     void writeToCgi();
     void readFromCgi();
     void cleanup_cgi();
-    // Helpers for checking request completeness
-    bool hasChunked(const std::string &request, size_t header_end) const;
-    bool checkEnd(const std::string &request, size_t header_end) const;
+    void closeCgiPipe(int &fd);
 
     // Member Variables
     int _socket;            // Thes client's socket file descriptor
-    HttpServer &_server;    // Reference to the main server for config access
+    const HttpServer &_server; // Shared, read-only server for config access
     Response *_response;    // Response object to build responses
     ClientState _state;     // The current state of the connection
     bool _keep_alive;       // Whether to keep the connection alive after response
     bool _peer_half_closed; // Peer performed shutdown(SHUT_WR); close after response
+    bool _request_ready;    // A pipelined request is parsed and waits for its response
 
     // Buffers
     std::string _request_buffer;  // Stores raw request data as it's read
-    std::string _response_buffer; // Stores the final, formatted response to be sent
-    size_t _response_offset;      // Bytes already sent from _response_buffer
+    OutputQueue _output;          // Responses to be sent, in request order
+    size_t _read_chunk;           // Current recv() size, see receive()
+    size_t _bytes_read;           // Read since the last takeBytesRead()
 
     // Parsers and Handlers
     HTTPparser _parser; // Parses the raw request
@@ -85,13 +132,18 @@ private:
 
     size_t _cgi_input_offset;       // Bytes of request body sent to CGI so far
     std::string _cgi_output_buffer; // Buffer to store output read from CGI
-    time_t _cgi_start_time;         // NEW
-    time_t _last_activity_time;     // Last time the client was active
 
     size_t _serverIndex; // Which server block this client belongs to
     int _serverPort;     // Which port client connected to
     int _status_code;    // HTTP status code for the response
 
+    PollRegistration _poll; // Descriptors/interest currently registered in the event loop
+    EventLoop *_loop;       // Loop of the owning reactor (CGI pipes leave it before close)
+    TimerWheel *_timers;    // Timer wheel of the owning reactor
+    TimerWheel::Timer _timer; // Pending timeout of the current state
+    OpenFileCache *_files;    // Open file cache of the owning reactor
+    ContentCache *_content;   // Content cache of the owning reactor
+
     // Private copy constructor and assignment operator to prevent copying
     Client(const Client &other);
     // Client& operator=(const Client& other);
@@ -0,0 +1,51 @@
+#ifndef CLIENTPOOL_HPP
+#define CLIENTPOOL_HPP
+
+#include "Common.hpp"
+
+class Client;
+
+/*
+  Free list of preallocated Client objects owned by one Reactor.
+
+  - reserve() allocates the whole pool up front (worker_connections split
+    over the reactors), so accepting a connection does not touch the heap
+  - release() resets a Client and puts it back; its request/response
+    buffers keep their capacity for the next connection
+  - When the pool is empty, acquire() falls back to new (a miss); surplus
+    clients are deleted on release so the pool never grows beyond capacity
+  - Not thread-safe: only the owning reactor thread may use it
+*/
+class ClientPool
+{
+public:
+    explicit ClientPool(const HttpServer &server);
+    ~ClientPool();
+
+    // Preallocate up to capacity idle clients
+    void reserve(size_t capacity);
+
+    // Bind a pooled (or, on a miss, freshly allocated) client to a connection
+    Client *acquire(int fd, size_t serverIndex, int serverPort);
+    // Reset the client and keep it for reuse; the socket is not closed here
+    void release(Client *cl);
+
+    size_t capacity() const { return _capacity; }
+    size_t available() const { return _free.size(); }
+    size_t inUse() const { return _inUse; }
+    unsigned long hits() const { return _hits; }
+    unsigned long misses() const { return _misses; }
+
+private:
+    const HttpServer &_server;
+    std::vector<Client *> _free;
+    size_t _capacity;
+    size_t _inUse;
+    unsigned long _hits;   // acquire() served from the free list
+    unsigned long _misses; // acquire() had to allocate
+
+    ClientPool(const ClientPool &other);
+    ClientPool &operator=(const ClientPool &other);
+};
+
+#endif
@@ -45,11 +45,17 @@ macros used throughout the project.*/
 #include <set>
 #include <vector>
 #include "ConfigParser.hpp" // configuration parser 
+#include "EventLoop.hpp" // epoll/select readiness backend
+#include "TimerWheel.hpp" // connection and CGI timeouts
+#include "OpenFileCache.hpp" // cached open()/stat() of static files
+#include "ContentCache.hpp" // rendered responses of small static files
+#include "OutputQueue.hpp" // responses waiting to be sent, as segments
 #include "HttpServer.hpp" // HTTP server
 #include "ErrorHandler.hpp"
 #include "HTTPparser.hpp" // parser for HTTP requests sent by the client
 #include "HTTPValidation.hpp" // HTTP validation utilities
 #include "HTTPRequestLine.hpp" // HTTP request line parser
+#include "HTTPURI.hpp" // request target: decoded, normalized path and query
 #include "HTTPHeaders.hpp" // HTTP headers parser
 #include "HTTPBody.hpp" // HTTP body parser
 #include "HttpResponse.hpp"
@@ -71,7 +77,20 @@ macros used throughout the project.*/
 
 // Global stop flag set by signal handlers
 extern volatile sig_atomic_t g_stop;
+// Bumped by SIGUSR1: every reactor then reports its counters once
+extern volatile sig_atomic_t g_statsRequest;
+// Bumped by SIGUSR2: start the binary on disk and hand it the listeners
+extern volatile sig_atomic_t g_upgradeRequest;
+// Set by SIGQUIT: stop accepting, finish in-flight requests, then exit
+extern volatile sig_atomic_t g_graceful;
 
-#define CLIENT_TIMEOUT 10
+// Timeout defaults in milliseconds, see ServerConfig/ParseTimeouts.cpp
+#define DEFAULT_CLIENT_HEADER_TIMEOUT 10000
+#define DEFAULT_KEEPALIVE_TIMEOUT 10000
+#define DEFAULT_SEND_TIMEOUT 10000
+#define DEFAULT_CGI_TIMEOUT 30000
+
+// Request bodies larger than this go to a temporary file (client_body_buffer_size)
+#define DEFAULT_CLIENT_BODY_BUFFER_SIZE (16 * 1024)
 
 #endif
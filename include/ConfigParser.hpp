@@ -16,6 +16,24 @@
 #include <set>
 #include "ServerConfig.hpp"
 
+// Upper bounds accepted by the worker_processes / worker_threads /
+// worker_connections directives
+#define WORKER_PROCESSES_MAX 256
+#define WORKER_THREADS_MAX 256
+#define WORKER_CONNECTIONS_MAX 65536
+#define WORKER_CONNECTIONS_DEFAULT 512
+
+// open_file_cache defaults; the cache is per event loop thread
+#define OPEN_FILE_CACHE_MAX 65536
+#define OPEN_FILE_CACHE_DEFAULT_MAX 256
+#define OPEN_FILE_CACHE_DEFAULT_INACTIVE_MS (20 * 1000)
+#define OPEN_FILE_CACHE_DEFAULT_VALID_MS (10 * 1000)
+#define OPEN_FILE_CACHE_TIME_MAX_MS (24UL * 60 * 60 * 1000)
+
+// content_cache_size: memory for rendered responses, per event loop thread
+#define CONTENT_CACHE_SIZE_MAX (1024UL * 1024 * 1024)
+#define CONTENT_CACHE_DEFAULT_SIZE (8UL * 1024 * 1024)
+
 class ConfigParser
 {
 private:
@@ -24,6 +42,14 @@ private:
     std::string _index;
 
     size_t _clientMaxBodySize;
+    size_t _workerProcesses; // worker_processes: 1 = no master/worker split
+    size_t _workerThreads;   // worker_threads: 1 = single event loop thread
+    size_t _workerConnections; // worker_connections: connection limit and Client pool size per process
+    size_t _openFileCacheMax;        // open_file_cache max=, 0 = off
+    size_t _openFileCacheInactiveMs; // open_file_cache inactive=
+    size_t _openFileCacheValidMs;    // open_file_cache_valid
+    bool _openFileCacheErrors;       // open_file_cache_errors
+    size_t _contentCacheSize;        // content_cache_size in bytes, 0 = off
     std::vector<ServerConfig> _servers; // For multiple server blocks
 
     // add more directives
@@ -36,6 +62,15 @@ private:
     void parseRoot(const std::string &val, size_t lineNo, std::string *root);
     void parseIndex(const std::string &val, size_t lineNo, std::string *index);
     void parseClientMaxBodySize(const std::string &val, size_t lineNo);
+    void parseWorkerProcesses(const std::string &val, size_t lineNo);
+    void parseWorkerThreads(const std::string &val, size_t lineNo);
+    void parseWorkerConnections(const std::string &val, size_t lineNo);
+    void parseOpenFileCache(const std::string &val, size_t lineNo);
+    void parseOpenFileCacheValid(const std::string &val, size_t lineNo);
+    void parseOpenFileCacheErrors(const std::string &val, size_t lineNo);
+    void parseContentCacheSize(const std::string &val, size_t lineNo);
+    size_t parseWorkerCount(const std::string &directive, const std::string &val, size_t max, size_t lineNo,
+                            bool allowAuto = true) const;
 
     // Helpers to keep parseLines small
     std::string preprocessLine(const std::string &raw);
@@ -62,6 +97,14 @@ public:
     const std::string &getIndex() const;
 
     size_t getClientMaxBodySize() const;
+    size_t getWorkerProcesses() const;
+    size_t getWorkerThreads() const;
+    size_t getWorkerConnections() const;
+    size_t getOpenFileCacheMax() const;
+    size_t getOpenFileCacheInactiveMs() const;
+    size_t getOpenFileCacheValidMs() const;
+    bool getOpenFileCacheErrors() const;
+    size_t getContentCacheSize() const;
 
     const std::vector<ServerConfig> &getServers() const;
 
@@ -0,0 +1,53 @@
+#ifndef CONNECTIONTABLE_HPP
+#define CONNECTIONTABLE_HPP
+
+#include <vector>
+#include <cstddef>
+
+class Client;
+
+/*
+  Client table of a Reactor, keyed by socket fd.
+
+  - A dense slot vector indexed by fd gives O(1) find/insert/erase; the
+    kernel hands out the lowest free descriptor, so it stays compact
+  - A packed list of the live fds is kept next to it for iteration; erase
+    moves the last entry into the hole, so iteration order is not stable
+*/
+class ConnectionTable
+{
+public:
+    ConnectionTable();
+
+    // Grow the slot vector up front (e.g. to worker_connections + spare fds)
+    void reserve(size_t fdCount);
+
+    // fd must not be in the table yet
+    void insert(int fd, Client *cl);
+    // Returns the removed client, NULL if fd was not in the table
+    Client *erase(int fd);
+    Client *find(int fd) const
+    {
+        return (fd >= 0 && static_cast<size_t>(fd) < _slots.size()) ? _slots[fd].client : NULL;
+    }
+
+    // Iteration over the live connections: fdAt(i) for i < size()
+    size_t size() const { return _active.size(); }
+    bool empty() const { return _active.empty(); }
+    int fdAt(size_t i) const { return _active[i]; }
+    Client *clientAt(size_t i) const { return _slots[_active[i]].client; }
+
+private:
+    struct Slot
+    {
+        Client *client;
+        size_t pos; // index of the fd in _active
+
+        Slot() : client(NULL), pos(0) {}
+    };
+
+    std::vector<Slot> _slots; // indexed by fd
+    std::vector<int> _active; // live fds, packed
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef CONTENTCACHE_HPP
+#define CONTENTCACHE_HPP
+
+#include <map>
+#include <string>
+#include "OpenFileCache.hpp"
+
+/*
+  Rendered responses (status line, headers and body) of small static files,
+  so a hit is one send() from memory without reading or building anything.
+
+  - Keyed by the caller (server block, resolved path and whatever changes
+    the header block); an entry also records the identity of the file it
+    was built from (device, inode, size, mtime) and is dropped when the
+    file no longer matches
+  - Bounded by a byte budget; the least recently used entries go first
+  - Entries are immutable and reference counted: a response that is being
+    sent keeps its entry alive after eviction, nothing is copied per request
+  - One cache per Reactor, so no locking
+*/
+class ContentCache
+{
+public:
+    class Entry
+    {
+    public:
+        const std::string &data() const { return _data; }
+        // The status line and headers at the start of data()
+        size_t headerLength() const { return _headerLen; }
+
+    private:
+        friend class ContentCache;
+
+        std::string _data;
+        size_t _headerLen;
+        OpenFileCache::File _file; // what the response was built from
+        unsigned int _refs;        // the cache's own one included while cached
+        Entry *_prev;              // LRU list, most recently used first
+        Entry *_next;
+        std::map<std::string, Entry *>::iterator _pos;
+
+        Entry() : _headerLen(0), _refs(0), _prev(NULL), _next(NULL) {}
+    };
+
+    ContentCache();
+    ~ContentCache();
+
+    // Byte budget, 0 turns the cache off
+    void configure(size_t budget);
+    bool enabled() const { return _budget != 0; }
+
+    // Entry for key if it was built from file as it is now, NULL otherwise.
+    // A returned entry is held for the caller until release().
+    Entry *acquire(const std::string &key, const OpenFileCache::File &file);
+    // Store the response built from file (taken from response, which is left
+    // empty), its header block being the first headerLen bytes. Returns the
+    // entry held for the caller, or NULL (and response untouched) if it does
+    // not fit the budget.
+    Entry *insert(const std::string &key, const OpenFileCache::File &file, std::string &response,
+                  size_t headerLen);
+    // Drop a reference; the entry may outlive the cache (see remove())
+    static void release(Entry *e);
+
+    size_t size() const { return _entries.size(); }
+    size_t bytes() const { return _bytes; }
+    unsigned long hits() const { return _hits; }
+    unsigned long misses() const { return _misses; }
+    unsigned long evictions() const { return _evictions; }
+
+private:
+    typedef std::map<std::string, Entry *> Map;
+
+    Map _entries;
+    Entry _lru; // list head: _lru._next is the most, _lru._prev the least recently used
+    size_t _budget;
+    size_t _bytes;
+    unsigned long _hits;
+    unsigned long _misses;
+    unsigned long _evictions;
+
+    static size_t cost(const std::string &key, const std::string &data);
+    void linkFront(Entry *e);
+    void unlink(Entry *e);
+    void remove(Entry *e);
+
+    ContentCache(const ContentCache &other);
+    ContentCache &operator=(const ContentCache &other);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#include <vector>
+#include <map>
+
+/*
+  Readiness notification backend for the server loop.
+
+  On Linux the loop is backed by epoll: descriptors are registered once and
+  only their interest mask is changed afterwards, so a wakeup costs
+  O(ready descriptors) instead of O(connections). Building with
+  -DWEBSERV_USE_SELECT (make USE_SELECT=1) or on a non-Linux platform falls
+  back to select(), which rebuilds its fd_sets from the registered interest
+  on every wait() and is limited to FD_SETSIZE descriptors.
+*/
+#if defined(__linux__) && !defined(WEBSERV_USE_SELECT)
+#define WEBSERV_USE_EPOLL 1
+#include <sys/epoll.h>
+#endif
+
+class EventLoop
+{
+public:
+    // Interest / readiness bits
+    enum
+    {
+        EV_NONE = 0,
+        EV_READ = 1,
+        EV_WRITE = 2
+    };
+
+    // One ready descriptor as reported by wait()
+    struct Event
+    {
+        int fd;
+        int events; // EV_READ and/or EV_WRITE; errors/hangups report both
+    };
+
+    EventLoop();
+    ~EventLoop();
+
+    // Create the kernel object (epoll instance); returns false on failure
+    bool init();
+
+    // Register, change or drop the interest of a descriptor.
+    // remove() must be called BEFORE the descriptor is closed.
+    bool add(int fd, int events);
+    bool modify(int fd, int events);
+    void remove(int fd);
+
+    // Wait up to timeoutMs (-1 = forever). Returns the number of ready
+    // descriptors, 0 on timeout and -1 on error (errno is preserved).
+    int wait(int timeoutMs);
+    const Event &ready(int i) const { return _ready[i]; }
+
+    const char *backendName() const;
+
+private:
+#ifdef WEBSERV_USE_EPOLL
+    int _epfd;
+    std::vector<struct epoll_event> _epollEvents;
+#else
+    std::map<int, int> _interest; // fd -> EV_* mask
+#endif
+    std::vector<Event> _ready;
+
+    EventLoop(const EventLoop &other);
+    EventLoop &operator=(const EventLoop &other);
+};
+
+#endif
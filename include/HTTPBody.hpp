@@ -14,50 +14,68 @@
 #define HTTPBODY_HPP
 
 #include <string>
-#include <sstream>
+#include <cstddef>
 
-// Forward declaration to avoid heavy includes in the header
-class HTTPHeaders;
+// A body buffer above this capacity is freed by reset() instead of being
+// kept for the next request
+#define HTTP_BODY_KEEP (64 * 1024)
+// Spooled bodies go to an unlinked file created from this template
+#define HTTP_BODY_TEMP_TEMPLATE "/tmp/webserv_body_XXXXXX"
 
 /*
-  HTTPBody is responsible for parsing and holding the HTTP request body.
-  It supports both fixed-length bodies (via Content-Length) and
-  Transfer-Encoding: chunked, including optional trailers.
+  HTTPBody holds the body of one HTTP request while HTTPparser frames it.
 
-  - Input stream must be positioned at the first byte of the body (i.e.,
-    immediately after the CRLF that ends the header section).
-  - The HTTPHeaders instance must represent the headers for the same request.
-  - On success, getBody() returns the raw body (no decoding beyond chunk
-    framing). The component does not interpret Content-Type; it only frames.
+  - HTTPparser decides the framing (Content-Length or Transfer-Encoding:
+    chunked) and hands over the payload bytes with append() as they arrive
+    from the socket, so a body is copied exactly once
+  - parseChunkSize() reads one "chunk-size[;chunk-ext]" line for the
+    chunked decoder
+  - getBody() returns the decoded body (no decoding beyond chunk framing).
+    The component does not interpret Content-Type; it only stores.
+  - Once a body grows past setBufferSize() (client_body_buffer_size) it
+    moves to a temporary file that is unlinked right away, so the kernel
+    removes it when the fd is closed. getBody() is empty then; readers use
+    getFd() (e.g. as the stdin of a CGI script).
 */
 class HTTPBody
 {
 private:
-    std::string _body;           // Parsed body content
-    bool        _isValid;        // Whether the body was parsed successfully
-    std::string _errorMessage;   // Error message when parsing fails
+    std::string _body;         // Body content received so far (unless spooled)
+    int _fd;                   // Temporary file holding the body, -1 while in memory
+    size_t _size;              // Body bytes received so far
+    size_t _bufferSize;        // Largest body kept in memory, 0 = no limit
+    std::string _errorMessage; // Error message when a chunk size is invalid
 
-    // Helpers
-    void setError(const std::string& message);
-    void trimTrailingCR(std::string& line);
+    void setError(const std::string &message);
+    bool spool();
+    bool writeFile(const char *data, size_t len);
 
-    bool parseFixedLengthBody(std::istringstream& iss, size_t length);
-    bool parseChunkedBody(std::istringstream& iss);
-    bool parseChunkSizeLine(std::istringstream& iss, size_t& outSize);
-    bool readExact(std::istringstream& iss, size_t length, std::string& out);
-    bool readCRLF(std::istringstream& iss);
+    HTTPBody(const HTTPBody &other);            // Owns _fd: not copyable
+    HTTPBody &operator=(const HTTPBody &other);
 
 public:
     HTTPBody();
     ~HTTPBody();
 
-    // Parse based on headers; method is for debug
-    bool parse(std::istringstream& iss, const HTTPHeaders& headers, const std::string& method);
+    // Add payload bytes (chunk framing already removed). Returns false if
+    // the temporary file cannot be created or written.
+    bool append(const char *data, size_t len);
+    // Expected body size is known: allocate once instead of growing (a
+    // body that will be spooled is not reserved)
+    void reserve(size_t len);
+    // Memory threshold for the following bodies; kept across reset()
+    void setBufferSize(size_t bufferSize) { _bufferSize = bufferSize; }
+
+    // Parse a chunk-size line (without its CRLF). Extensions
+    // after ';' are ignored; returns false on a malformed or huge size.
+    bool parseChunkSize(const std::string &line, size_t &outSize);
 
     // Getters
-    const std::string& getBody() const { return _body; }
-    bool isValid() const { return _isValid; }
-    const std::string& getErrorMessage() const { return _errorMessage; }
+    const std::string &getBody() const { return _body; }
+    size_t size() const { return _size; }
+    bool isInFile() const { return _fd != -1; }
+    int getFd() const { return _fd; }
+    const std::string &getErrorMessage() const { return _errorMessage; }
 
     // Reset state
     void reset();
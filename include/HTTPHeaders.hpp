@@ -14,93 +14,124 @@
 #define HTTPHEADERS_HPP
 
 #include <string>
-#include <map>
-#include <sstream>
 #include <vector>
+#include <cstddef>
+#include "HTTPKnownHeaders.hpp"
 
 /*
   This class handles:
   - Parsing header lines from HTTP request
   - Validation of header names and values according to HTTP specifications
   - Special handling for important headers (Content-Length, Transfer-Encoding, etc.)
-  - Case-insensitive header name lookup via lowercase keys
+  - Case-insensitive header name lookup, O(1) for the known headers
   - Error detection and reporting
 
+  Storage: the header section is kept exactly as received (raw()), and
+  every header is an offset/length slice into it. Names are compared
+  case-insensitively in place and nothing is copied or lowercased, so
+  parsing a request allocates nothing once raw() and the field vector
+  have grown to size (both keep their capacity across reset()). An owned
+  std::string is only built when a caller asks for a value.
+
   Implementation notes:
   - Header folding (obsolete line folding) is not supported; each header
     must be a single line with a colon.
+  - A repeated header: lookups return the last one, iteration sees all.
+  - Known headers (HTTPKnownHeaders) are identified once while parsing;
+    the last line of each is kept in a fixed slot, so getHeader(id) and
+    the special getters need no name compare at all.
   - For HTTP/1.1, the Host header is typically required from clients;
     enforcement is not implemented here but could be added in validateHeaders().
  */
 class HTTPHeaders
 {
+public:
+  // One header line: offsets into raw()
+  struct Field
+  {
+    size_t name;     // Field name as received
+    size_t nameLen;
+    size_t value;    // Field value, surrounding whitespace trimmed
+    size_t valueLen;
+    HTTPHeaderId id; // HEADER_UNKNOWN for other names
+  };
+
 private:
-  std::map<std::string, std::string> _headers;      // Header key-value pairs (keys are lowercase)
-  std::map<std::string, std::string> _originalKeys; // Original case mapping
-  size_t _contentLength;                            // Parsed Content-Length value
-  bool _hasContentLength;                           // Whether Content-Length header is present
-  bool _isChunked;                                  // Whether Transfer-Encoding: chunked
-  std::string _contentType;                         // Content-Type header value
-  std::string _host;                                // Host header value
-  std::string _connection;                          // Connection header value
-  std::string _transferEncoding;                    // Transfer-Encoding header value
-  bool _isValid;                                    // Whether headers are valid
-  std::string _errorMessage;                        // Error message if parsing fails
-  std::string _hostName;                            // Parsed host name from Host header
-  std::string _hostPort;                            // Parsed port from Host header
+  std::string _raw;           // Request line and header lines as received
+  std::vector<Field> _fields; // Header lines in arrival order
+  size_t _contentLength;      // Parsed Content-Length value
+  bool _hasContentLength;     // Whether Content-Length header is present
+  bool _isChunked;            // Whether Transfer-Encoding: chunked
+  int _known[HEADER_COUNT];   // Index in _fields of each known header, -1 if absent
+  bool _isValid;              // Whether headers are valid
+  std::string _errorMessage;  // Error message if parsing fails
 
   // Helper methods
-  bool parseHeaderLine(const std::string &line);
-  void processSpecialHeaders(const std::string &lowerName, const std::string &value);
+  bool processSpecialHeaders(size_t index);
   void setError(const std::string &message);
-  std::string toLowercase(const std::string &str) const;
-  void trimTrailingCR(std::string &line);
-  bool isEmptyLine(const std::string &line) const;
+  int findField(const std::string &name) const;
+  int findField(HTTPHeaderId id) const { return id < HEADER_COUNT ? _known[id] : -1; }
+  std::string fieldValue(int index) const;
 
   // Content-Length parsing
-  bool parseContentLength(const std::string &value);
+  bool parseContentLength(const Field &field);
 
   // Transfer-Encoding parsing
-  bool parseTransferEncoding(const std::string &value);
-
-  // Host header parsing for CGI
-  void parseHostHeader(const std::string &hostValue);
+  bool parseTransferEncoding(const Field &field);
 
 public:
   HTTPHeaders();
   ~HTTPHeaders();
 
-  // Main parsing method
-  bool parseHeaders(std::istringstream &iss);
+  // The header section; HTTPparser collects the request line and the
+  // header lines in here as they arrive
+  std::string &raw() { return _raw; }
+  const std::string &raw() const { return _raw; }
+
+  // Parsing, one line at a time as HTTPparser receives them: every header
+  // line (offset/length in raw(), without CRLF, and the offset of its
+  // first ':' as found by HTTPScanner, npos if none), then finishHeaders()
+  // at the empty line
+  bool parseHeaderLine(size_t offset, size_t len, size_t colon);
+  bool finishHeaders();
 
-  // Header manipulation
-  bool addHeader(const std::string &name, const std::string &value);
+  // Header lookup (case-insensitive, no copy of the name)
   bool hasHeader(const std::string &name) const;
   std::string getHeader(const std::string &name) const;
-  void removeHeader(const std::string &name);
+  // Value as a slice of raw(), NULL if the header is absent
+  const char *findHeader(const std::string &name, size_t &len) const;
+  // Same for a known header, without hashing the name
+  bool hasHeader(HTTPHeaderId id) const { return findField(id) >= 0; }
+  std::string getHeader(HTTPHeaderId id) const { return fieldValue(findField(id)); }
+  const char *findHeader(HTTPHeaderId id, size_t &len) const;
 
   // getters for headers
   size_t getContentLength() const { return _contentLength; }
   bool hasContentLength() const { return _hasContentLength; }
   bool isChunked() const { return _isChunked; }
-  const std::string &getContentType() const { return _contentType; }
-  const std::string &getHost() const { return _host; }
-  const std::string &getConnection() const { return _connection; }
-  const std::string &getTransferEncoding() const { return _transferEncoding; }
-  const std::string &getHostName() const { return _hostName; }
-  const std::string &getHostPort() const { return _hostPort; }
+  std::string getContentType() const { return getHeader(HEADER_CONTENT_TYPE); }
+  std::string getHost() const { return getHeader(HEADER_HOST); }
+  std::string getConnection() const { return getHeader(HEADER_CONNECTION); }
+  std::string getTransferEncoding() const { return getHeader(HEADER_TRANSFER_ENCODING); }
+  // Host header split for CGI SERVER_NAME and SERVER_PORT
+  std::string getHostName() const;
+  std::string getHostPort() const;
+
+  // Iteration over all header lines
+  size_t getHeaderCount() const { return _fields.size(); }
+  std::string getName(size_t i) const { return _raw.substr(_fields[i].name, _fields[i].nameLen); }
+  std::string getValue(size_t i) const { return _raw.substr(_fields[i].value, _fields[i].valueLen); }
+  HTTPHeaderId getId(size_t i) const { return _fields[i].id; }
 
   // getters
-  const std::map<std::string, std::string> &getAllHeaders() const { return _headers; }
   bool isValid() const { return _isValid; }
   const std::string &getErrorMessage() const { return _errorMessage; }
-  size_t getHeaderCount() const { return _headers.size(); }
 
   // Validation
   bool validateHeaders() const;
 
-  // Reset
+  // Reset (keeps the allocated capacity for the next request)
   void reset();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,71 @@
+#ifndef HTTPKNOWNHEADERS_HPP
+#define HTTPKNOWNHEADERS_HPP
+
+#include <cstddef>
+
+// Request headers the server knows by name. HTTPHeaders keeps the last
+// occurrence of each in a fixed slot indexed by this id.
+enum HTTPHeaderId
+{
+    HEADER_ACCEPT,
+    HEADER_ACCEPT_CHARSET,
+    HEADER_ACCEPT_ENCODING,
+    HEADER_ACCEPT_LANGUAGE,
+    HEADER_AUTHORIZATION,
+    HEADER_CACHE_CONTROL,
+    HEADER_CONNECTION,
+    HEADER_CONTENT_LENGTH,
+    HEADER_CONTENT_TYPE,
+    HEADER_COOKIE,
+    HEADER_EXPECT,
+    HEADER_HOST,
+    HEADER_IF_MODIFIED_SINCE,
+    HEADER_IF_NONE_MATCH,
+    HEADER_IF_RANGE,
+    HEADER_IF_UNMODIFIED_SINCE,
+    HEADER_ORIGIN,
+    HEADER_RANGE,
+    HEADER_REFERER,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_UPGRADE,
+    HEADER_USER_AGENT,
+    HEADER_X_FORWARDED_FOR,
+    HEADER_COUNT,
+    HEADER_UNKNOWN = HEADER_COUNT
+};
+
+/*
+  Static registry of the known header names.
+
+  - lookup() maps a name (any case) to its id with a perfect hash over the
+    length and three of its bytes: one table probe and one compare, no
+    allocation
+  - The CGI variable of each header (HTTP_USER_AGENT, ...) is precomputed,
+    so building the CGI environment does not transform names
+*/
+class HTTPKnownHeaders
+{
+public:
+    // name must be a valid token (HTTPValidation::isValidHeaderName)
+    static HTTPHeaderId lookup(const char *name, size_t len);
+
+    // Canonical spelling, e.g. "Content-Length"
+    static const char *getName(HTTPHeaderId id) { return _entries[id].name; }
+    // CGI meta-variable, NULL if the header is not passed to scripts
+    static const char *getCgiName(HTTPHeaderId id) { return _entries[id].cgiName; }
+
+private:
+    struct Entry
+    {
+        const char *name;
+        size_t len;
+        const char *cgiName;
+    };
+
+    static const Entry _entries[HEADER_COUNT];
+    static const unsigned char _slots[64];
+
+    HTTPKnownHeaders(); // Prevent instantiation
+};
+
+#endif
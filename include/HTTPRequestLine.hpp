@@ -14,7 +14,32 @@
 #define HTTPREQUESTLINE_HPP
 
 #include <string>
-#include <sstream>
+#include <cstddef>
+
+// Request methods the server recognises; any other token is METHOD_OTHER
+// (valid syntax, answered with 405 by the routing layer)
+enum HTTPMethod
+{
+    METHOD_GET,
+    METHOD_HEAD,
+    METHOD_POST,
+    METHOD_PUT,
+    METHOD_DELETE,
+    METHOD_CONNECT,
+    METHOD_OPTIONS,
+    METHOD_TRACE,
+    METHOD_PATCH,
+    METHOD_OTHER
+};
+
+// Protocol versions the server accepts; a request line with another one
+// is rejected. HTTP_VERSION_UNKNOWN until a request line is parsed.
+enum HTTPVersion
+{
+    HTTP_1_0,
+    HTTP_1_1,
+    HTTP_VERSION_UNKNOWN
+};
 
 /*
   The request line is the first line of an HTTP request and contains:
@@ -22,50 +47,53 @@
   Example: GET /index.html HTTP/1.1
   
   This class handles:
-  - Parsing the method, path, and version from the request line
+  - Parsing the method, path, and version from the request line in one
+    pass over the bytes, without copying them: method and version become
+    enums from static tables, the request target is kept as a slice
+    (offset and length in the parsed line)
   - Validation of each component according to HTTP specifications  
   - Error detection and reporting
+
+  Components are separated by runs of whitespace, as the stream based
+  parser accepted before.
  */
 class HTTPRequestLine
 {
 private:
-    std::string _rawLine;   // Original request line for debugging
-    std::string _method;    // HTTP Method (GET, POST, DELETE, etc.)
-    std::string _path;      // Path of the requested resource
-    std::string _version;   // HTTP Version (HTTP/1.0, HTTP/1.1)
-    bool _isValid;          // Whether the request line is valid
-    std::string _errorMessage; // Error message if parsing fails
+    HTTPMethod _method;         // Method id, METHOD_OTHER for unknown tokens
+    std::string _otherMethod;   // Spelling of a METHOD_OTHER method
+    HTTPVersion _version;       // HTTP Version (HTTP/1.0, HTTP/1.1)
+    size_t _target;             // Offset of the request target in the line
+    size_t _targetLen;          // Its length
+    bool _isValid;              // Whether the request line is valid
+    std::string _errorMessage;  // Error message if parsing fails
+
+    static const std::string _methodNames[METHOD_OTHER];
+    static const std::string _versionNames[HTTP_VERSION_UNKNOWN + 1];
 
-    // Helper methods (shuold be private because they are only used by the parseRequestLine method)
     void setError(const std::string& message);
-    bool parseComponents(std::istringstream& iss);
-    void trimTrailingCR(std::string& line);
+    static HTTPMethod lookupMethod(const char *name, size_t len);
 
 public:
     HTTPRequestLine();
     ~HTTPRequestLine();
     
-    // Main parsing method
+    // Main parsing method: line without its CRLF. Allocates nothing for a
+    // valid request line with a known method.
+    bool parseRequestLine(const char *line, size_t len);
     bool parseRequestLine(const std::string& requestLine);
     
-    // Validation methods
-    bool validateMethod(const std::string& method);
-    bool validatePath(const std::string& path);
-    bool validateVersion(const std::string& version);
-    
     // Getters
-    const std::string& getMethod() const { return _method; }
-    const std::string& getPath() const { return _path; }
-    const std::string& getVersion() const { return _version; }
-    const std::string& getRawLine() const { return _rawLine; }
+    HTTPMethod getMethodId() const { return _method; }
+    HTTPVersion getVersionId() const { return _version; }
+    const std::string& getMethod() const;
+    const std::string& getVersion() const { return _versionNames[_version]; }
+    // Request target as a slice of the line passed to parseRequestLine()
+    size_t getTargetOffset() const { return _target; }
+    size_t getTargetLength() const { return _targetLen; }
     bool isValid() const { return _isValid; }
     const std::string& getErrorMessage() const { return _errorMessage; }
     
-    // Setters
-    void setMethod(const std::string& method) { _method = method; }
-    void setPath(const std::string& path) { _path = path; }
-    void setVersion(const std::string& version) { _version = version; }
-    
     // Reset the object to initial state
     void reset();
 };
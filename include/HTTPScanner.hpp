@@ -0,0 +1,35 @@
+#ifndef HTTPSCANNER_HPP
+#define HTTPSCANNER_HPP
+
+#include <string>
+#include <cstddef>
+
+/*
+  Delimiter scanning for the header section of a request.
+
+  - findLineEnd() looks for the LF that ends a line and for the first ':'
+    in front of it (the name/value separator of a header field); a CR
+    before the LF is left to the caller
+  - The end of the header section needs no search of its own: it is the
+    first empty line, so the parser finds it line by line and never scans
+    a byte twice, however the request is split over recv() calls
+  - Both searches are memchr(): the ':' is looked for only in front of the
+    LF and only until it is found, so the second call covers the field
+    name alone. A one-pass SSE2/AVX2 scan for both delimiters was measured
+    against this (bench/http_scanner) and lost on all but the shortest
+    header blocks.
+*/
+class HTTPScanner
+{
+public:
+    // Offset of the first '\n' in data[0, len), len if there is none.
+    // If colon is npos on entry it is set to the offset of the first ':'
+    // before that point, so a line received in pieces can be scanned piece
+    // by piece (the caller offsets the result of each piece).
+    static size_t findLineEnd(const char *data, size_t len, size_t &colon);
+
+private:
+    HTTPScanner(); // Prevent instantiation
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef HTTPURI_HPP
+#define HTTPURI_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/*
+  The request target of a request line, taken apart once per request:
+
+    /cgi-bin/a%20b.py?x=1&y=2
+    \_______________/ \_____/
+          path         query
+
+  - The path is percent-decoded first and normalized after: "." and ".."
+    segments are resolved and repeated slashes merged (RFC 3986 5.2.4), so
+    an encoded "%2e%2e" or "%2F" cannot step out of the root. A ".." above
+    the root, a malformed %-escape or a decoded control character make
+    the target invalid.
+  - The query is kept as sent (CGI scripts decode QUERY_STRING themselves)
+  - getSegments() lists the segments of the normalized path
+
+  Routing, file lookup and caching all use getPath(), the normalized form.
+*/
+class HTTPURI
+{
+public:
+    // A segment of the normalized path (offset and length in getPath())
+    struct Segment
+    {
+        size_t offset;
+        size_t len;
+    };
+
+    HTTPURI();
+    ~HTTPURI();
+
+    // target: the request target of the request line (origin-form)
+    bool parse(const char *target, size_t len);
+    void reset();
+
+    const std::string &getTarget() const { return _target; }
+    const std::string &getPath() const { return _path; }
+    const std::string &getQuery() const { return _query; }
+    bool hasQuery() const { return _hasQuery; }
+    const std::vector<Segment> &getSegments() const { return _segments; }
+    const std::string &getErrorMessage() const { return _errorMessage; }
+
+private:
+    std::string _target;           // Request target as received
+    std::string _path;             // Decoded, normalized path
+    std::string _query;            // Query without its '?'
+    bool _hasQuery;                // A '?' was present (the query may be empty)
+    std::vector<Segment> _segments;
+    std::string _errorMessage;
+
+    bool decodePath(const char *path, size_t len);
+    bool normalizePath();
+    bool setError(const std::string &message);
+};
+
+#endif
@@ -36,6 +36,7 @@ private:
 public:
     // HTTP Method validation
     static bool isValidMethod(const std::string& method);
+    static bool isValidMethod(const char* method, size_t len);
     static std::set<std::string> getValidMethods();
     
     // HTTP Version validation
@@ -44,13 +45,23 @@ public:
     
     // Path validation (security checks for directory traversal, etc.)
     static bool isValidPath(const std::string& path);
+    static bool isValidPath(const char* path, size_t len);
+    // Characters of a request target (path and query); ".." segments are
+    // resolved later by HTTPURI
+    static bool isValidTarget(const char* path, size_t len);
     static bool containsDirectoryTraversal(const std::string& path);
+    static bool containsDirectoryTraversal(const char* path, size_t len);
     static std::string sanitizePath(const std::string& path);
     
     // Header validation
     static bool isValidHeaderName(const std::string& name);
     static bool isValidHeaderValue(const std::string& value);
     static bool containsInvalidChars(const std::string& value);
+    // Same checks on a slice of a buffer (no copy)
+    static bool isValidHeaderName(const char* name, size_t len);
+    static bool isValidHeaderValue(const char* value, size_t len);
+    // Case-insensitive compare of a slice with a NUL-terminated string
+    static bool equalsIgnoreCase(const char* str, size_t len, const char* other);
     
     // String utilities
     static std::string trim(const std::string& str);
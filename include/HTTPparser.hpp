@@ -14,60 +14,107 @@
 #define HTTPPARSER_HPP
 
 #include "HTTPRequestLine.hpp"
+#include "HTTPURI.hpp"
 #include "HTTPHeaders.hpp"
+#include "HTTPBody.hpp"
+#include "HTTPScanner.hpp"
 #include <string>
 #include <map>
 #include <vector>
 #include <sstream>
 
+struct LocationConfig;
+
+// Upper bound for the request line plus all header lines; a client that
+// sends more without finishing the header section gets a 400
+#define HTTP_MAX_HEADER_SIZE (64 * 1024)
+// Upper bound for one chunk-size or trailer line of a chunked body
+#define HTTP_MAX_CHUNK_LINE 4096
+// Largest body buffer reserved up front from Content-Length
+#define HTTP_BODY_RESERVE_MAX (16 * 1024 * 1024)
+
 /*
  Since TCP is a stream-based protocol, HTTP requests are not guaranteed
  to arrive in a single packet or a single recv() call. A large request,
  a slow network, or packet fragmentation can cause the data to arrive
  in pieces. The parser must be designed to handle incremental arrival.
 
- The HTTPparser operates as a state machine. It consumes data and
- transitions through several states. This allows future extension to
- incremental parsing (e.g., feeding partial buffers from non-blocking I/O).
+ The HTTPparser operates as a state machine. feed() consumes the bytes of
+ every recv() exactly once and keeps its position between calls: a
+ partial line waits in the parser, body bytes go straight to HTTPBody.
 */
 enum State
 {
     PARSING_REQUEST_LINE = 0,
     PARSING_HEADERS = 1,
-    PARSING_BODY = 2,
+    PARSING_BODY = 2,          // Content-Length body
     PARSING_CHUNKED_BODY = 3,
-    PARSING_CHUNK_SIZE = 4,
-    PARSING_CHUNK_DATA = 5,
+    PARSING_CHUNK_SIZE = 4,    // chunk-size line
+    PARSING_CHUNK_DATA = 5,    // chunk payload
     PARSING_COMPLETE = 6,
-    ERROR = 7
+    ERROR = 7,
+    PARSING_CHUNK_DATA_END = 8, // CRLF after the chunk payload
+    PARSING_TRAILERS = 9        // trailer section after the last chunk
 };
 
 /*
   HTTPparser is the controller that orchestrates parsing the entire
   HTTP request. It delegates specialized work to dedicated components:
   - HTTPRequestLine: parses the first line (method, path, version)
-  - HTTPHeaders: parses the header block
-  - HTTPBody: parses the message body (fixed-length or chunked)
-
-  The class also tracks a parsing state (State enum) to reflect progress
-  and to prepare for future incremental parsing.
+  - HTTPURI: splits, decodes and normalizes the request target
+  - HTTPHeaders: parses the header lines
+  - HTTPBody: stores the message body (fixed-length or chunked)
+
+  The request framing (where the header section and the body end) is
+  decided here, once, while the bytes are fed in. So is the body size
+  limit: a Content-Length over setMaxBodySize() fails with a 413 as soon
+  as the headers are complete (the connection is closed after it). A
+  chunked body only shows its size as it arrives, so it is still framed to
+  its end, keeping the connection in sync, but not stored, and then fails
+  with a 413.
 */
 class HTTPparser
 {
+public:
+    // Result of feed()
+    enum FeedResult
+    {
+        NEED_MORE,        // Message not complete yet
+        HEADERS_COMPLETE, // Header section finished in this call, body pending
+        MESSAGE_COMPLETE, // Whole request parsed; see getConsumed()
+        FEED_ERROR        // Malformed request; see getErrorStatusCode()
+    };
+
 private:
     State _state;                 // Current state of the parser
-    std::string _HTTPrequest;     // Raw request data for debugging
     HTTPRequestLine _requestLine; // Request line parser
+    HTTPURI _uri;                 // Request target: decoded, normalized path and query
     HTTPHeaders _headers;         // Headers parser
-    std::string _body;            // Body content
-    std::string _buffer;          // Buffer for incremental parsing
+    HTTPBody _body;               // Body content
+    size_t _lineStart;            // Offset in _headers.raw() of the line being received
+    size_t _colon;                // Offset in _headers.raw() of its first ':', npos if none yet
+    bool _headersDone;            // Header section parsed (body may still be pending)
+    std::string _line;            // Partial chunk-size/CRLF/trailer line
+    size_t _remaining;            // Bytes left of the fixed body or the current chunk
+    size_t _consumed;             // Bytes of the last feed() that belong to this message
+    size_t _maxBodySize;          // client_max_body_size, 0 = no limit; kept across reset()
+    bool _bodyTooLarge;           // Body exceeds _maxBodySize, its bytes are dropped
     std::string _errorStatusCode; // Error status if parsing fails
     bool _isValid;                // Whether the request is valid
     std::string _errorMessage;    // Detailed error message
     std::string _currentFilePath; // Current file path for the request
+    const LocationConfig *_currentLocation; // Location block matched for the request
     std::string _serverName;      // Server name from Host header
     std::string _serverPort;      // Server port from Host header
 
+    // Framing steps of feed()
+    size_t feedHeaderSection(const char *data, size_t len);
+    size_t feedBody(const char *data, size_t len);
+    bool parseHeaderSectionLine(size_t offset, size_t len, size_t colon);
+    bool parseBodyLine(const std::string &line);
+    void startBody();
+    void complete();
+
     // Helpers for body parsing and state management
     void setState(State s);
     void trimTrailingCR(std::string &line);
@@ -77,38 +124,68 @@ public:
     HTTPparser();
     ~HTTPparser();
 
-    // Main parsing methods
+    // Incremental parsing: hand over the bytes of each recv() as they come.
+    // Stops at the end of the message; the bytes after it (the next
+    // pipelined request) are not consumed.
+    FeedResult feed(const char *data, size_t len);
+    // The peer will not send more: a message still incomplete is an error.
+    // Returns isValid().
+    bool finish();
+    // Parse a complete request in one go (feed() + finish())
     bool parseRequest(const std::string &rawRequest);
-    bool parseRequestLine(std::istringstream &iss);
-    bool parseHeaders(std::istringstream &iss);
-    bool parseBody(std::istringstream &iss);
+    // Limit for the (decoded) body of the following requests, 0 = none
+    void setMaxBodySize(size_t maxBodySize) { _maxBodySize = maxBodySize; }
+    // Bodies larger than this are spooled to a temporary file, 0 = never
+    void setBodyBufferSize(size_t bufferSize) { _body.setBufferSize(bufferSize); }
 
     // State management
     State getState() const { return _state; }
     bool isValid() const { return _isValid; }//changed for testing
+    bool headersComplete() const { return _headersDone; }
+    // Any byte of a request seen yet (leading empty lines do not count)
+    bool hasStarted() const { return _state != PARSING_REQUEST_LINE || !_headers.raw().empty(); }
+    bool isBodyTooLarge() const { return _bodyTooLarge; }
+    size_t getConsumed() const { return _consumed; }
+    // Body bytes still expected for a Content-Length body (0 otherwise)
+    size_t getRemainingBody() const { return _state == PARSING_BODY ? _remaining : 0; }
     const std::string &getErrorMessage() const { return _errorMessage; }
     const std::string &getErrorStatusCode() const { return _errorStatusCode; }
 
     // Request line accessors (delegate to HTTPRequestLine)
+    HTTPMethod getMethodId() const { return _requestLine.getMethodId(); }
+    HTTPVersion getVersionId() const { return _requestLine.getVersionId(); }
     const std::string &getMethod() const { return _requestLine.getMethod(); }
-    const std::string &getPath() const { return _requestLine.getPath(); }
     const std::string &getVersion() const { return _requestLine.getVersion(); }
 
+    // Request target accessors (delegate to HTTPURI). getPath() is the
+    // decoded, normalized path; getTarget() the target as sent.
+    const HTTPURI &getUri() const { return _uri; }
+    const std::string &getPath() const { return _uri.getPath(); }
+    const std::string &getQuery() const { return _uri.getQuery(); }
+    const std::string &getTarget() const { return _uri.getTarget(); }
+
     // Headers accessors (delegate to HTTPHeaders)
-    const std::map<std::string, std::string> &getHeaders() const { return _headers.getAllHeaders(); }
+    const HTTPHeaders &getHeaders() const { return _headers; }
     std::string getHeader(const std::string &name) const { return _headers.getHeader(name); }
     bool hasHeader(const std::string &name) const { return _headers.hasHeader(name); }
     size_t getContentLength() const { return _headers.getContentLength(); }
     bool hasContentLength() const { return _headers.hasContentLength(); }
     bool isChunked() const { return _headers.isChunked(); }
 
-    // Body accessors
-    const std::string &getBody() const { return _body; }
+    // Body accessors. A spooled body is not in getBody(): read it from
+    // getBodyFd() (-1 while the body is in memory)
+    const std::string &getBody() const { return _body.getBody(); }
+    size_t getBodySize() const { return _body.size(); }
+    int getBodyFd() const { return _body.getFd(); }
 
     // Current file path accessors
     const std::string &getCurrentFilePath() const { return _currentFilePath; }
     void setCurrentFilePath(const std::string &path) { _currentFilePath = path; }
 
+    // Location matched for this request (NULL until routed or if none matched)
+    const LocationConfig *getCurrentLocation() const { return _currentLocation; }
+    void setCurrentLocation(const LocationConfig *loc) { _currentLocation = loc; }
+
     // Server name and port accessors
     const std::string &getServerName() const { return _serverName; }
     const std::string &getServerPort() const { return _serverPort; }
@@ -36,16 +36,21 @@ class Response
     std::string _response_body;
     std::string _response;
     std::string body;
-    std::string _response_headers;
-    std::string _response_final;
+    std::string _response_headers; // Status line and headers (a redirect: the whole response)
     std::string _loc;
     std::string _request;
     int _code;
     std::string root;
     std::string _path;
     int _ServerIndex;
-    HttpServer &_HttpServer;
+    int _file_fd;      // Static file sent after the headers, -1 if none
+    off_t _file_size;  // Its size (Content-Length) from fstat()
+    OpenFileCache::File _file_info; // The static file: its validators, what openFile() found
+    ContentCache::Entry *_cached;   // Whole response from the content cache, NULL if none
+    const HttpServer &_HttpServer;
     HTTPparser &_HttpParser;
+    OpenFileCache &_files; // stat()/open() of static files and error pages
+    ContentCache &_content; // rendered responses of small static files
 
 public:
     // Response();
@@ -53,11 +58,12 @@ public:
     // HTTPparser _HTTPParser;
     // ConfigParser _ConfigParser;
 
-    Response(HttpServer &server, HTTPparser &HttpParser, ConfigParser &ConfigParser, int serverIndex);
+    Response(const HttpServer &server, HTTPparser &HttpParser, const ConfigParser &ConfigParser, int serverIndex,
+             OpenFileCache &files, ContentCache &content);
     void setRequest(std::string request);
     ~Response();
     HTTPparser request;
-    ConfigParser &_ConfigParser;
+    const ConfigParser &_ConfigParser;
     void appDate();
     void appContentType();
     void appContentLen();
@@ -65,6 +71,7 @@ public:
     void buildResponse(const std::string &cgiOutput);
     void setHeaders();
     void connection();
+    bool keepAlive() const;
     //void server();
     void builderror_body(int code);
     void builderror_responses(int code);
@@ -75,6 +82,13 @@ public:
     std::string statusMessage(int code);
     void statusLine();
     bool fileExists(const std::string& name);
+    bool openFile(const std::string &path);
+    bool findCached();
+    bool notModified() const;
+    void appValidators();
+    void storeCached();
+    std::string cacheKey() const;
+    size_t cacheLimit() const;
     //int buildResponse();
     //int _cgi;
     void server();
@@ -83,7 +97,10 @@ public:
     int stringToInt(const std::string &str);
     void buildErrorPage(int code);
     // std::string getResponse();
-    std::string processResponse(std::string request, int code, const std::string &cgiOutput);
+    void processResponse(std::string request, int code, const std::string &cgiOutput);
+    // Hand the built response to out: the header block, then the body from
+    // memory, the opened file or the content cache. Nothing is concatenated.
+    void takeOutput(OutputQueue &out);
     std::string redirecUtil();
     const Response &operator=(const Response &other);
     void setStatusCode(int code) { _code = code; }
@@ -4,4 +4,10 @@
 
 std::string generateDirectoryListing(std::string path,std::string requestPath);
 
+// Conditional GET helpers
+std::string httpDate(time_t t);
+bool parseHttpDate(const char *value, size_t len, time_t &t);
+std::string makeETag(const OpenFileCache::File &file);
+bool etagListMatches(const char *list, size_t len, const std::string &etag);
+
 #endif
\ No newline at end of file
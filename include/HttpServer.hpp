@@ -19,9 +19,21 @@ class Client; // forward declaration
 // class ConfigParser;
 class HTTPparser;
 class Response;
+class Reactor;
+
+// TCP_DEFER_ACCEPT timeout of 'listen ... deferred': a silent connection is
+// handed to accept() after this many seconds anyway
+#define LISTEN_DEFER_ACCEPT_SECS 10
+
+// Connections accepted per listener and wakeup; the rest waits in the backlog
+#define ACCEPT_BATCH 64
+// How often accepting is retried while paused (worker_connections reached,
+// or accept() ran out of descriptors)
+#define ACCEPT_RESUME_POLL_MS 100
 
 class HttpServer
 {
+public:
     // Structure to track socket info
     struct ServerSocketInfo
     {
@@ -38,17 +50,30 @@ private:
     std::string _root;
     std::string _index;
     std::vector<ServerConfig> _servers; // Store multiple server configs
-    // Active clients keyed by socket fd
-    std::map<int, Client *> _clients;
     std::vector<ServerSocketInfo> _serverSockets;
-    const LocationConfig *_currentLocation;
-    // Config parser reference
-    // Response &_response;
 
-    void mapCurrentLocationConfig(const std::string &path, const int serverIndex);
+    // Event loops (Reactor.cpp). With worker_threads 1 a single reactor runs
+    // on the main thread; otherwise one per thread and the main thread only
+    // accepts. Everything a request touches on HttpServer itself is
+    // read-only, so all reactors share this object and its config.
+    std::vector<Reactor *> _reactors;
+    size_t _nextReactor; // round-robin start for the least-loaded search
+
+    size_t _workerProcesses; // worker_processes directive (1 = single process)
+    size_t _workerThreads;   // worker_threads directive (1 = single event loop)
+    size_t _workerConnections; // worker_connections directive (Client pool size)
+
+    // Binary upgrade (BinaryUpgrade.cpp)
+    std::vector<std::string> _argv; // command line to exec on SIGUSR2
+    std::vector<int> _inheritedFds; // listeners passed in by the old process
+    pid_t _upgradeParent;           // old process to SIGQUIT once we listen
+
+    const LocationConfig *findLocation(const std::string &path, const int serverIndex) const;
 
     // Socket setup
-    int createAndBindSocket(int port, in_addr_t host);
+    int createAndBindSocket(int port, in_addr_t host, bool reusePort, const ListenOptions &opts);
+    static std::string describeListenSocket(int server_fd, const ListenOptions &opts);
+    bool openServerSockets(bool reusePort, bool verbose);
     void setupSignalHandlers();
     void printStartupMessage();
     bool validateConfiguration();
@@ -56,22 +81,51 @@ private:
     // Accept loop for incoming connections
     // int runAcceptLoop(int server_fd);
     int runMultiServerAcceptLoop(const std::vector<ServerSocketInfo> &serverSockets);
+    int runThreadedAcceptLoop(const std::vector<ServerSocketInfo> &serverSockets);
+    Reactor *pickReactor();
+    size_t connectionCount(Reactor *owner) const;
+
+    // Binary upgrade and graceful stop (BinaryUpgrade.cpp)
+    void loadInheritedSockets();
+    int takeInheritedSocket(int port, in_addr_t host);
+    void closeInheritedSockets();
+    void notifyUpgradeParent();
+
+    // Master/worker process model (WorkerProcesses.cpp)
+    int runMaster();
+    int runWorker(size_t workerIndex);
 
 public:
-    HttpServer(ConfigParser &configParser);
+    HttpServer(const ConfigParser &configParser);
     //HttpServer();               // As a default constructor for HTTPResponse
-    ConfigParser _configParser; // changed from private to public for access in response.cpp
+    const ConfigParser &_configParser; // changed from private to public for access in response.cpp
     ~HttpServer();
 
-    std::string getFilePath(const std::string &path, const int serverIndex); // changed from private for response.cpp
-    bool determineKeepAlive(const HTTPparser &parser);                       // changed from private to public for access in response.cpp
-    const LocationConfig *getCurrentLocation();
+    std::string getFilePath(const std::string &path, const int serverIndex, const LocationConfig *loc) const; // changed from private for response.cpp
+    bool determineKeepAlive(const HTTPparser &parser) const;                                                 // changed from private to public for access in response.cpp
 
-    // Helper: map location for path and return resolved file path
-    std::string resolveFilePathFor(const std::string &path, const int serverIndex);
+    // Helper: match the location for the request path and store it, together
+    // with the resolved file path, in the request; returns the file path
+    std::string resolveFilePathFor(HTTPparser &request, const int serverIndex) const;
 
     static bool setNonBlocking(int fd);
 
+    // Accept up to ACCEPT_BATCH pending connections on a listening socket and
+    // hand them to owner, or to the least-loaded reactor thread when owner is
+    // NULL (public for Reactor access). Returns false when accepting must
+    // pause: worker_connections is reached or descriptors ran out.
+    bool acceptConnections(const ServerSocketInfo &info, Reactor *owner);
+    size_t getWorkerConnections() const { return _workerConnections; }
+
+    // Remember argv so SIGUSR2 can exec the same command line again
+    void setCommandLine(int argc, char **argv);
+    // SIGUSR2: fork/exec the binary on disk with the listening sockets
+    // inherited; returns false if it could not be started
+    bool spawnUpgrade();
+    // SIGQUIT: close the listening sockets for good (after removing them
+    // from the event loop that watches them)
+    void stopListening();
+
     // Start the non-blocking HTTP server with Client class state machine
     // Returns 0 on normal exit, non-zero on error
     int start();
@@ -81,11 +135,11 @@ public:
     std::string generateGetResponse(const std::string &path, bool keepAlive);
     std::string generateMethodNotAllowedResponse(bool keepAlive);
     std::string generatePostResponse(const std::string &body, bool keepAlive);
-    bool isMethodAllowed(const std::string &method);
+    bool isMethodAllowed(const LocationConfig *loc, const std::string &method) const;
 
     void handleClient(int client_fd);
-    size_t checkContentLength(const std::string &request, size_t header_end);
-    size_t getServerMaxBodySize(size_t serverIndex);
+    size_t getServerMaxBodySize(size_t serverIndex) const;
+    const ServerConfig &getServerConfig(size_t serverIndex) const;
 };
 
 #endif
@@ -14,6 +14,10 @@ public:
 
     // Log raw HTTP response data with timestamp
     static void logResponse(const std::string &raw);
+    // Only the first len bytes of raw (the header block of a whole response)
+    static void logResponse(const std::string &raw, size_t len);
+    // Same for a response whose header block and body are kept apart
+    static void logResponse(const std::string &headers, const std::string &body);
 
 private:
     // Build a timestamp string in the format: [YYYY-MM-DD HH:MM:SS]
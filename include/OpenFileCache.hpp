@@ -0,0 +1,100 @@
+#ifndef OPENFILECACHE_HPP
+#define OPENFILECACHE_HPP
+
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <stdint.h>
+#include "TimerWheel.hpp"
+
+/*
+  Cache of filesystem lookups on the static file path of a Reactor, after
+  nginx's open_file_cache (open_file_cache, open_file_cache_valid and
+  open_file_cache_errors directives).
+
+  - Keyed by the resolved path; an entry holds the stat() result, the open
+    descriptor of a regular file, or the errno of a failed lookup (negative
+    entry), so repeated requests for missing paths cost no syscalls either
+  - An entry is trusted for validMs; after that one stat() checks that the
+    path still names the same, unchanged file, otherwise it is loaded again
+  - Bounded: at most max entries (least recently used go first), and
+    entries unused for inactiveMs are closed by expire()
+  - One cache per Reactor, so no locking; its clock is the timer wheel's
+*/
+class OpenFileCache
+{
+public:
+    // What a lookup found out about a path
+    struct File
+    {
+        int err;      // errno of the failed lookup (ENOENT, EACCES, ...), 0 if found
+        bool isDir;
+        bool isReg;
+        off_t size;
+        time_t mtime;
+        dev_t dev;    // identity of the file, to notice a replaced one
+        ino_t ino;
+
+        File() : err(0), isDir(false), isReg(false), size(0), mtime(0), dev(0), ino(0) {}
+    };
+
+    explicit OpenFileCache(const TimerWheel &clock);
+    ~OpenFileCache();
+
+    // max 0 turns the cache off: every lookup goes to the filesystem
+    void configure(size_t max, uint64_t inactiveMs, uint64_t validMs, bool cacheErrors);
+
+    // Metadata of path; false if it cannot be looked up (info.err says why)
+    bool stat(const std::string &path, File &info);
+    // Descriptor of the regular file at path (close-on-exec); the caller
+    // owns and closes it. -1 if path is not a regular file that opens.
+    int open(const std::string &path, File &info);
+
+    // Drop entries unused for inactiveMs; call once per loop iteration
+    void expire();
+
+    size_t size() const { return _entries.size(); }
+    unsigned long hits() const { return _hits; }
+    unsigned long misses() const { return _misses; }
+
+private:
+    struct Entry;
+    typedef std::map<std::string, Entry *> Map;
+
+    struct Entry
+    {
+        File file;
+        int fd;              // open regular file, -1 otherwise
+        uint64_t validUntil; // trusted without a stat() until then
+        uint64_t lastUsed;
+        Entry *prev;         // LRU list, most recently used first
+        Entry *next;
+        Map::iterator pos;
+
+        Entry() : fd(-1), validUntil(0), lastUsed(0), prev(NULL), next(NULL) {}
+    };
+
+    const TimerWheel &_clock;
+    Map _entries;
+    Entry _lru;     // list head: _lru.next is the most, _lru.prev the least recently used
+    Entry _scratch; // result of a lookup that is not cached
+    size_t _max;
+    uint64_t _inactiveMs;
+    uint64_t _validMs;
+    bool _cacheErrors;
+    unsigned long _hits;
+    unsigned long _misses;
+
+    Entry *lookup(const std::string &path);
+    static void load(const std::string &path, Entry &e);
+    static void unload(Entry &e);
+    static bool unchanged(const std::string &path, const Entry &e);
+    void linkFront(Entry *e);
+    void unlink(Entry *e);
+    void remove(Entry *e);
+
+    OpenFileCache(const OpenFileCache &other);
+    OpenFileCache &operator=(const OpenFileCache &other);
+};
+
+#endif
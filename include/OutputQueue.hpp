@@ -0,0 +1,73 @@
+#ifndef OUTPUTQUEUE_HPP
+#define OUTPUTQUEUE_HPP
+
+#include <deque>
+#include <string>
+#include <sys/types.h>
+#include "ContentCache.hpp"
+
+// Memory segments gathered into one sendmsg()
+#define OUTPUT_IOV_MAX 64
+
+/*
+  The responses of a connection that are waiting to be sent, as a list of
+  segments in send order:
+
+  - memory owned by the queue (a header block, a generated body), taken
+    from the caller's string without copying
+  - memory shared with the content cache (a whole cached response)
+  - a range of an open file, sent with sendfile()
+
+  send() writes consecutive memory segments with one sendmsg(), so a header
+  block and its body (or several pipelined responses) leave in one call
+  without being concatenated first. Progress is tracked across segments;
+  finished ones are dropped, closing their file or releasing their entry.
+*/
+class OutputQueue
+{
+public:
+    OutputQueue();
+    ~OutputQueue();
+
+    // Appends the data, leaving data empty; empty strings are skipped
+    void push(std::string &data);
+    // Appends a cached response; the caller's reference goes to the queue
+    void push(ContentCache::Entry *entry);
+    // Appends size bytes of fd from its start; the queue closes fd
+    void pushFile(int fd, off_t size);
+
+    // One send call for what is at the front. Returns what it returned:
+    // bytes sent, 0 if a file ended early, -1 on error.
+    ssize_t send(int socket);
+
+    bool empty() const { return _segments.empty(); }
+    // Bytes still to be sent
+    off_t size() const { return _size; }
+    void clear();
+
+private:
+    struct Segment
+    {
+        std::string data;           // memory owned by the segment, or
+        ContentCache::Entry *entry; // memory shared with the content cache, or
+        int fd;                     // an open file, sent from fileOffset up to fileEnd
+        off_t fileOffset;
+        off_t fileEnd;
+        size_t sent;                // bytes of data or entry already sent
+
+        Segment() : entry(NULL), fd(-1), fileOffset(0), fileEnd(0), sent(0) {}
+    };
+
+    std::deque<Segment> _segments;
+    off_t _size;
+
+    static const std::string &memory(const Segment &s);
+    ssize_t sendMemory(int socket);
+    ssize_t sendFile(int socket);
+    void popFront();
+
+    OutputQueue(const OutputQueue &other);
+    OutputQueue &operator=(const OutputQueue &other);
+};
+
+#endif
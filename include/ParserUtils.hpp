@@ -12,6 +12,11 @@ public:
 	static bool isBlockMarker(const std::string &line);
 	static std::string stripTrailingSemicolon(const std::string &line);
 	static bool splitKeyVal(const std::string &line, std::string &key, std::string &val);
+	// Positive duration like 10, 10s, 500ms, 2m, 1h or 30d (a bare number
+	// is in seconds, like nginx), at most maxMs; stored in milliseconds
+	static bool parseDuration(const std::string &val, unsigned long maxMs, size_t &ms);
+	// Positive size like 8192, 16k or 1m, at most max bytes
+	static bool parseSize(const std::string &val, unsigned long max, size_t &bytes);
 };
 
 #endif
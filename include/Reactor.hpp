@@ -0,0 +1,117 @@
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include "Common.hpp"
+#include "ClientPool.hpp"
+#include "ConnectionTable.hpp"
+#include <pthread.h>
+
+class Client;
+
+/*
+  A Reactor is one event loop together with everything it drives: its client
+  table, the CGI pipes of those clients and their timeouts. None of that is
+  shared, so the only lock is the one around the handoff queue through which
+  the acceptor passes in new connections. The open file cache is per
+  reactor for the same reason.
+
+  - worker_threads 1: a single reactor runs on the main thread and watches
+    the listening sockets itself
+  - worker_threads N: the main thread only accepts and posts every new fd to
+    the least-loaded of N reactor threads
+*/
+class Reactor
+{
+    // Client that owns a registered CGI pipe descriptor
+    struct PipeOwner
+    {
+        Client *client;
+        unsigned long generation; // loop iteration in which the pipe was registered
+
+        PipeOwner() : client(NULL), generation(0) {}
+        PipeOwner(Client *c, unsigned long gen) : client(c), generation(gen) {}
+    };
+
+    // Connection accepted on another thread, waiting to be adopted
+    struct Handoff
+    {
+        int fd;
+        HttpServer::ServerSocketInfo info;
+
+        Handoff(int f, const HttpServer::ServerSocketInfo &i) : fd(f), info(i) {}
+    };
+
+public:
+    // poolSize: number of Client objects preallocated for this reactor
+    Reactor(HttpServer &server, size_t id, size_t poolSize);
+    ~Reactor();
+
+    // Create the event loop and the wakeup pipe; returns false on failure
+    bool init();
+
+    // Run until g_stop is set. Listening sockets are only passed in
+    // single-threaded mode; their connections are accepted through
+    // HttpServer::acceptConnections() with this reactor as owner. That
+    // reactor also answers SIGUSR2 and, after SIGQUIT, returns once its
+    // last connection is done.
+    int run(const std::vector<HttpServer::ServerSocketInfo> &listeners);
+
+    // Take over a freshly accepted connection (reactor thread only).
+    // The fd is closed if it cannot be registered.
+    void adopt(int fd, const HttpServer::ServerSocketInfo &info);
+
+    // Thread-safe: queue an accepted connection and wake the reactor up
+    void post(int fd, const HttpServer::ServerSocketInfo &info);
+    // Thread-safe: interrupt a blocking wait so g_stop is noticed at once
+    void wakeup();
+    // Thread-safe: connections owned plus connections still queued
+    size_t load();
+
+    size_t getId() const { return _id; }
+
+private:
+    HttpServer &_server; // clients only get read-only access
+    size_t _id;
+
+    // Readiness backend: sockets and CGI pipes are registered once and their
+    // interest is only updated when the owning client changes state.
+    EventLoop _loop;
+    ConnectionTable _clients;                // Active clients keyed by socket fd
+    ClientPool _pool;                        // Recycled Client objects
+    size_t _poolSize;
+    sig_atomic_t _statsSeen;                 // last g_statsRequest reported
+    sig_atomic_t _upgradeSeen;               // last g_upgradeRequest handled
+    unsigned long _readWakeups;              // socket wakeups that read request data
+    unsigned long long _readBytes;           // request bytes read in those wakeups
+    std::vector<PipeOwner> _cgiPipeOwners;   // indexed by CGI pipe fd; client NULL = not a pipe
+    unsigned long _loopGeneration;           // incremented after every wait()
+    TimerWheel _timers;                      // client timeouts; its clock is refreshed after every wait()
+    OpenFileCache _files;                    // static file lookups of this reactor's clients
+    ContentCache _content;                   // their rendered small static file responses
+    std::vector<TimerWheel::Timer *> _expired;
+
+    // Handoff from the acceptor thread; _owned mirrors _clients.size() so
+    // load() never touches the client table from another thread.
+    pthread_mutex_t _queueLock;
+    std::vector<Handoff> _queue;
+    size_t _owned;
+    int _wakeupPipe[2];
+
+    void dispatchClientEvent(Client *cl, int events);
+    void updateClientEvents(Client *cl);
+    void watchCgiPipe(Client *cl, int fd, int events);
+    void unwatchCgiPipe(int fd);
+    PipeOwner *findPipeOwner(int fd);
+    void closeClient(int fd);
+    void expireTimers(std::vector<int> &toClose);
+    void collectIdleClients(std::vector<int> &toClose);
+    void drainWakeupPipe();
+    void adoptQueued();
+    void updateOwned();
+    void dumpStats();
+
+    Reactor(const Reactor &other);
+    Reactor &operator=(const Reactor &other);
+};
+
+#endif
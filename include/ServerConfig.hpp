@@ -4,6 +4,16 @@
 
 #include <set>
 #include <netinet/in.h> // For in_addr_t
+
+// Default listen() backlog when the listen directive sets none
+#define LISTEN_BACKLOG_DEFAULT 128
+// content_cache: largest file whose response is kept in memory
+#define CONTENT_CACHE_FILE_MAX (16UL * 1024 * 1024)
+#define CONTENT_CACHE_DEFAULT_FILE_MAX (64UL * 1024)
+// expires: Cache-Control max-age of static files in seconds, or
+#define EXPIRES_OFF -1   // no Cache-Control header
+#define EXPIRES_EPOCH -2 // Cache-Control: no-cache
+#define EXPIRES_MAX (10L * 365 * 24 * 60 * 60)
 //  Location configuration structure to hold per-location settings
 struct LocationConfig
 {
@@ -15,9 +25,24 @@ struct LocationConfig
     bool cgiPass;
     std::string cgiExtension;
     std::map<int, std::string> redirect;
+    size_t contentCacheMax; // content_cache: largest file cached in memory, 0 = off
+    long expires;           // expires: max-age in seconds, EXPIRES_OFF or EXPIRES_EPOCH
 
     LocationConfig()
-        : path(""), root(""), index(), allowedMethods(), autoindex(false), cgiPass(false), cgiExtension(""), redirect() {}
+        : path(""), root(""), index(), allowedMethods(), autoindex(false), cgiPass(false), cgiExtension(""), redirect(),
+          contentCacheMax(CONTENT_CACHE_DEFAULT_FILE_MAX), expires(EXPIRES_OFF) {}
+};
+
+// Parameters of a listen directive after the address, e.g.
+//   listen 8080 backlog=1024 deferred fastopen=256 reuseport;
+struct ListenOptions
+{
+    int backlog;    // listen() queue length (capped by net.core.somaxconn)
+    bool deferred;  // TCP_DEFER_ACCEPT: wake up only once the client sent data
+    int fastopen;   // TCP_FASTOPEN queue length, 0 = off
+    bool reuseport; // SO_REUSEPORT even with a single worker process
+
+    ListenOptions() : backlog(LISTEN_BACKLOG_DEFAULT), deferred(false), fastopen(0), reuseport(false) {}
 };
 
 class ServerConfig
@@ -26,6 +51,7 @@ private:
     std::string _configFile;
     std::vector<int> _ports;         // Keep for backward compatibility
     std::vector<std::string> _hosts; // Keep for backward compatibility
+    std::vector<ListenOptions> _listenOptions; // parallel to _ports
     // std::vector<std::pair<std::string, int> > _listenAddresses; // host:port pairs (C++98 syntax)
     std::string _root;
     std::string _index;
@@ -34,6 +60,13 @@ private:
     std::map<int, std::string> _errorPage;
 
     size_t _clientMaxBodySize;
+    size_t _clientBodyBufferSize; // larger request bodies are spooled to a temp file
+
+    // Timeouts in milliseconds (ParseTimeouts.cpp)
+    size_t _clientHeaderTimeout; // idle time allowed while a request is received
+    size_t _keepaliveTimeout;    // idle time allowed between two requests
+    size_t _cgiTimeout;          // total run time of a CGI script
+    size_t _sendTimeout;         // idle time allowed while a response is sent
     // std::string _host;     // Keep for backward compatibility
     std::string _location; // to implement later
 
@@ -44,13 +77,16 @@ private:
 
     // Per-directive parsers
     void parseListen(const std::string &val, size_t lineNo);
+    void parseListenOption(const std::string &option, size_t lineNo, ListenOptions *opts);
     void parseRoot(const std::string &val, size_t lineNo, std::string *root);
     void parseIndex(const std::string &val, size_t lineNo, std::string *index);
     void parseServerName(const std::string &val, size_t lineNo);
     void parseHost(const std::string &val, size_t lineNo);
     void parseClientMaxBodySize(const std::string &val, size_t lineNo);
+    void parseClientBodyBufferSize(const std::string &val, size_t lineNo);
     void parseAllowedMethods(const std::string &val, size_t lineNo, std::set<std::string> *allowedMethods = NULL);
     void parseErrorPage(const std::string &val, size_t lineNo);
+    void parseTimeout(const std::string &directive, const std::string &val, size_t lineNo, size_t *timeoutMs);
 
     // Helpers to keep parseLines small
     std::string preprocessLine(const std::string &raw);
@@ -74,6 +110,7 @@ public:
     int getListenPort() const;
     const std::vector<int> &getListenPorts() const;         // Get all ports
     const std::vector<std::string> &getListenHosts() const; // Get all hosts
+    const std::vector<ListenOptions> &getListenOptions() const; // Socket options, parallel to ports
     // const std::vector<std::pair<std::string, int>> &getListenAddresses() const; // Get host:port pairs
     const std::string &getRoot() const;
     const std::string &getIndex() const;
@@ -83,7 +120,12 @@ public:
     in_addr_t getHost() const;
     const std::map<std::string, LocationConfig> &getLocations() const;
     size_t getClientMaxBodySize() const;
+    size_t getClientBodyBufferSize() const;
     const std::string &getErrorPage(int status_code) const;
+    size_t getClientHeaderTimeout() const;
+    size_t getKeepaliveTimeout() const;
+    size_t getCgiTimeout() const;
+    size_t getSendTimeout() const;
 
     // TODO: implement error handling
     // TODO: implement parsing more directives (directives are the lines in the config file)
@@ -98,6 +140,8 @@ public:
     void applyCgiPass(LocationConfig *loc, const std::string &val, size_t lineNo);
     void applyCgiExtension(LocationConfig *loc, const std::string &val, size_t lineNo);
     void applyRedirect(LocationConfig *loc, const std::string &val, size_t lineNo);
+    void applyContentCache(LocationConfig *loc, const std::string &val, size_t lineNo);
+    void applyExpires(LocationConfig *loc, const std::string &val, size_t lineNo);
 };
 
 #endif
@@ -0,0 +1,85 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <vector>
+#include <stdint.h>
+#include <cstddef>
+
+/*
+  Hierarchical timing wheel driving the per-connection timeouts of a Reactor.
+
+  - Timers are intrusive nodes owned by whoever arms them (e.g. a Client), so
+    arm() and cancel() are a list splice with no allocation: O(1)
+  - The first level has 256 slots of TICK_MS each; three coarser levels of 64
+    slots hold later timers and are cascaded down whenever the level below
+    wraps around (same scheme as the classic Linux timer wheel)
+  - The clock is CLOCK_MONOTONIC, read once per loop iteration through
+    updateClock(); now() returns that cached value
+  - Delays beyond the range of the wheel (~7.7 days) are clamped
+*/
+class TimerWheel
+{
+public:
+    struct Timer
+    {
+        Timer *prev;
+        Timer *next;
+        uint64_t expires; // absolute tick
+        void *data;       // owner, for the caller of expire()
+
+        Timer() : prev(NULL), next(NULL), expires(0), data(NULL) {}
+        bool armed() const { return next != NULL; }
+    };
+
+    enum
+    {
+        TICK_MS = 10
+    };
+
+    TimerWheel();
+
+    // Refresh the cached monotonic clock; call once after every wait()
+    void updateClock();
+    uint64_t now() const { return _nowMs; }
+
+    // (Re-)arm a timer to fire delayMs after the cached clock
+    void arm(Timer &t, uint64_t delayMs);
+    // Disarm a timer; harmless when it is not armed
+    void cancel(Timer &t);
+
+    // Unlink every timer that is due at the cached clock and append it to out
+    void expire(std::vector<Timer *> &out);
+
+    // Milliseconds until the next timer may fire, at most maxMs
+    int nextTimeoutMs(int maxMs) const;
+
+    size_t size() const { return _count; }
+
+private:
+    enum
+    {
+        ROOT_BITS = 8,
+        LEVEL_BITS = 6,
+        ROOT_SIZE = 1 << ROOT_BITS,
+        LEVEL_SIZE = 1 << LEVEL_BITS,
+        LEVELS = 3 // above the root
+    };
+
+    uint64_t _nowMs;
+    uint64_t _currentTick; // next tick to be processed by expire()
+    size_t _count;
+
+    // Slot heads are sentinels of circular doubly linked lists
+    Timer _root[ROOT_SIZE];
+    Timer _levels[LEVELS][LEVEL_SIZE];
+
+    void insert(Timer &t);
+    void cascade(int level, size_t index);
+    static void link(Timer &head, Timer &t);
+    static void unlink(Timer &t);
+
+    TimerWheel(const TimerWheel &other);
+    TimerWheel &operator=(const TimerWheel &other);
+};
+
+#endif
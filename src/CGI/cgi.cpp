@@ -2,7 +2,7 @@
 #include "Common.hpp"
 
 // Utility function to convert number to string
-std::string CGI::numberToString(int number)
+std::string CGI::numberToString(size_t number)
 {
 	std::stringstream ss;
 	ss << number;
@@ -22,7 +22,7 @@ CGI::CGI()
 	// Initialize other members to empty/default values
 	script_path_ = "";
 	interpreter_path_ = "";
-	request_body_ = "";
+	body_fd_ = -1;
 }
 
 // Constructor
@@ -39,7 +39,9 @@ CGI::CGI(const HTTPparser &request)
 	script_path_ = request.getCurrentFilePath();
 
 	interpreter_path_ = "/usr/bin/env";
-	request_body_ = request.getBody();
+	// A body spooled to a file becomes the script's stdin directly; one in
+	// memory is written to the input pipe by the Client
+	body_fd_ = request.getBodyFd();
 
 	setupEnvironment(request);
 }
@@ -53,7 +55,7 @@ CGI::~CGI()
 // Setup environment variables
 void CGI::setupEnvironment(const HTTPparser &request)
 {
-	const std::map<std::string, std::string> &headers = request.getHeaders();
+	const HTTPHeaders &headers = request.getHeaders();
 
 	// Required CGI environment variables
 
@@ -62,31 +64,37 @@ void CGI::setupEnvironment(const HTTPparser &request)
 	const char *sys_path = getenv("PATH");
 	env_["PATH"] = sys_path ? sys_path : "/usr/bin:/bin:/usr/sbin:/sbin";
 	env_["AUTH_TYPE"] = "";
-	env_["CONTENT_TYPE"] = headers.count("content-type") > 0 ? headers.find("content-type")->second : "";
+	env_["CONTENT_TYPE"] = headers.getContentType();
 	env_["GATEWAY_INTERFACE"] = "CGI/1.1";
 	env_["PATH_INFO"] = request.getPath();
 	env_["PATH_TRANSLATED"] = script_path_;
 	env_["REQUEST_METHOD"] = request.getMethod();
-	env_["REQUEST_URI"] = request.getPath();
+	env_["REQUEST_URI"] = request.getTarget();
+	env_["QUERY_STRING"] = request.getQuery();
 	env_["SCRIPT_NAME"] = request.getPath();
 	env_["SCRIPT_FILENAME"] = script_path_;
 	env_["SERVER_NAME"] = request.getServerName().empty() ? "localhost" : request.getServerName();
 	env_["SERVER_PORT"] = request.getServerPort().empty() ? "8080" : request.getServerPort();
 	env_["SERVER_PROTOCOL"] = "HTTP/1.1";
 	env_["SERVER_SOFTWARE"] = "webserv/1.0";
-	env_["CONTENT_LENGTH"] = numberToString(request_body_.size());
+	env_["CONTENT_LENGTH"] = numberToString(request.getBodySize());
 
 	// Add all HTTP headers as environment variables
-	for (std::map<std::string, std::string>::const_iterator it = headers.begin();
-		 it != headers.end(); ++it)
+	for (size_t i = 0; i < headers.getHeaderCount(); ++i)
 	{
-		// Skip transfer-encoding as it's server-internal framing
-		if (it->first == "transfer-encoding")
+		HTTPHeaderId id = headers.getId(i);
+		if (id != HEADER_UNKNOWN)
+		{
+			// Precomputed name; NULL for transfer-encoding, which is
+			// server-internal framing
+			if (HTTPKnownHeaders::getCgiName(id) != NULL)
+				env_[HTTPKnownHeaders::getCgiName(id)] = headers.getValue(i);
 			continue;
-		std::string env_name = "HTTP_" + it->first;
+		}
+		std::string env_name = "HTTP_" + headers.getName(i);
 		std::replace(env_name.begin(), env_name.end(), '-', '_');
 		std::transform(env_name.begin(), env_name.end(), env_name.begin(), ::toupper);
-		env_[env_name] = it->second;
+		env_[env_name] = headers.getValue(i);
 	}
 }
 
@@ -130,6 +138,32 @@ char **CGI::createArgsArray() const
 	args[3] = NULL;
 	return args;
 }
+
+// Free an array built by createEnvArray() / createArgsArray()
+static void freeArray(char **arr)
+{
+	if (!arr)
+		return;
+	for (size_t i = 0; arr[i]; ++i)
+		delete[] arr[i];
+	delete[] arr;
+}
+
+// Pipes are close-on-exec so a CGI forked by one reactor thread never
+// inherits (and keeps open) the pipes of a CGI started by another one.
+// dup2() clears the flag on the child's stdin/stdout copies.
+static int makePipe(int fds[2])
+{
+#ifdef O_CLOEXEC
+	return pipe2(fds, O_CLOEXEC);
+#else
+	if (pipe(fds) == -1)
+		return -1;
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	return 0;
+#endif
+}
 // TODO:: need to create a common util for non blocking setting for Server and CGI
 static bool setNonBlocking(int fd)
 {
@@ -152,25 +186,22 @@ static bool setNonBlocking(int fd)
 	return true;
 }
 
-// Setup pipes
-void CGI::setupPipes()
+// Setup pipes; without needInput stdin comes from body_fd_
+void CGI::setupPipes(bool needInput)
 {
-	if (pipe(pipe_in_) == -1)
+	if (needInput && makePipe(pipe_in_) == -1)
 	{
 		std::cerr << "Error: Input pipe creation failed: " << strerror(errno) << std::endl;
 		return;
 	}
-	if (pipe(pipe_out_) == -1)
+	if (makePipe(pipe_out_) == -1)
 	{
 		std::cerr << "Error: Output pipe creation failed: " << strerror(errno) << std::endl;
-		close(pipe_in_[0]);
-		close(pipe_in_[1]);
-		pipe_in_[0] = pipe_in_[1] = -1;
-		pipe_out_[0] = pipe_out_[1] = -1;
+		closePipes();
 		return;
 	}
 	// Set pipes to non-blocking mode
-	if (!setNonBlocking(pipe_in_[1]) || !setNonBlocking(pipe_out_[0]))
+	if ((needInput && !setNonBlocking(pipe_in_[1])) || !setNonBlocking(pipe_out_[0]))
 	{
 		closePipes();
 		return;
@@ -226,16 +257,34 @@ int CGI::execute()
 		return -1;
 	}
 
-	setupPipes();
-	if (pipe_in_[0] == -1 || pipe_out_[0] == -1)
+	setupPipes(body_fd_ == -1);
+	if ((body_fd_ == -1 && pipe_in_[0] == -1) || pipe_out_[0] == -1)
+	{
+		return -1;
+	}
+	// The spooled body was written up to its end: read it from the start
+	if (body_fd_ != -1 && lseek(body_fd_, 0, SEEK_SET) == -1)
 	{
+		std::cerr << "Error: Cannot rewind request body file: " << strerror(errno) << std::endl;
+		closePipes();
 		return -1;
 	}
 
+	// Prepare environment and arguments before forking: in a multi-threaded
+	// server the child may only rely on async-signal-safe calls
+	char **envp = createEnvArray();
+	char **args = createArgsArray();
+	std::string dir;
+	size_t last_slash = script_path_.find_last_of("/");
+	if (last_slash != std::string::npos)
+		dir = script_path_.substr(0, last_slash);
+
 	cgi_pid_ = fork();
 	if (cgi_pid_ == -1)
 	{
 		std::cerr << "Error: Fork failed: " << strerror(errno) << std::endl;
+		freeArray(envp);
+		freeArray(args);
 		closePipes();
 		return -1;
 	}
@@ -243,45 +292,58 @@ int CGI::execute()
 	if (cgi_pid_ == 0)
 	{ // Child process (CGI)
 		// Set up I/O redirection
-		dup2(pipe_in_[0], STDIN_FILENO);
+		dup2(body_fd_ != -1 ? body_fd_ : pipe_in_[0], STDIN_FILENO);
 		dup2(pipe_out_[1], STDOUT_FILENO);
 		dup2(pipe_out_[1], STDERR_FILENO);
 
 		closePipes();
 		// Change to script directory for relative paths
-		size_t last_slash = script_path_.find_last_of("/");
-		if (last_slash != std::string::npos)
+		if (!dir.empty() && chdir(dir.c_str()) == -1)
 		{
-			std::string dir = script_path_.substr(0, last_slash);
-			if (chdir(dir.c_str()) == -1)
-			{
-				std::cerr << "Warning: Could not change to script directory" << std::endl;
-			}
+			// write() only: another thread may have held the iostream or
+			// stdio lock at fork(), which the child would wait on forever
+			static const char msg[] = "Warning: Could not change to script directory\n";
+			ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+			(void)ignored;
 		}
 
-		// Prepare environment and arguments
-		char **envp = createEnvArray();
-		char **args = createArgsArray();
-
 		if (!envp || !args)
 		{
-			exit(EXIT_FAILURE);
+			_exit(EXIT_FAILURE);
 		}
+		// Ignored signals stay ignored across execve; give the script the
+		// default SIGPIPE behaviour back
+		signal(SIGPIPE, SIG_DFL);
 		execve(interpreter_path_.c_str(), args, envp);
 
 		// If execve fails
-		std::cerr << "Error: execve failed: " << strerror(errno) << std::endl;
-		exit(EXIT_FAILURE);
+		static const char msg[] = "Error: execve failed\n";
+		ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+		(void)ignored;
+		_exit(EXIT_FAILURE);
 	}
 	else
 	{						 // Parent process (server)
+		freeArray(envp);
+		freeArray(args);
 		close(pipe_in_[0]);	 // Close read end of input pipe
 		close(pipe_out_[1]); // Close write end of output pipe
+		pipe_in_[0] = pipe_out_[1] = -1;
 
 		return 0;
 	}
 }
 
+// Hand the parent-side pipe ends over to the caller. The CGI object forgets
+// them, so its cleanup can never close a descriptor number that the caller
+// already closed and the kernel handed out again (possibly to a connection
+// served by another thread).
+void CGI::releasePipes()
+{
+	pipe_in_[1] = -1;
+	pipe_out_[0] = -1;
+}
+
 // The cleanup only close pipes — do NOT kill/reap child unconditionally.
 // The Client calls waitpid/kill when it decides the CGI lifecycle ended.
 void CGI::cleanup()
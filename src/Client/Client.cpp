@@ -1,6 +1,5 @@
 #include "Client.hpp"
 #include "Logger.hpp"
-#include <ctime> // NEW
 
 /*
 Client::readRequest()
@@ -29,62 +28,116 @@ Client::writeResponse()
     return true;
 }*/
 
-Client::Client(int fd, HttpServer &server, size_t serverIndex, int serverPort)
-    : _socket(fd),
+// Pooled clients are constructed idle; open() binds them to a connection
+Client::Client(const HttpServer &server)
+    : _socket(-1),
 
       _server(server),
       _response(NULL),
-      _state(READING),
+      _state(CLOSING),
       _keep_alive(false),
       _peer_half_closed(false),
+      _request_ready(false),
       _request_buffer(),
-      _response_buffer(),
-      _response_offset(0),
+      _output(),
+      _read_chunk(CLIENT_READ_CHUNK_MIN),
+      _bytes_read(0),
       _parser(),
       _cgi_handler(),
       _cgi_pid(-1),
       _cgi_started(false),
-      _cgi_start_time(0), 
-      _last_activity_time(time(NULL)), // Initialize with current time
-      _serverIndex(serverIndex),
-      _serverPort(serverPort),
-      _status_code(200)
+      _cgi_input_offset(0),
+      _serverIndex(0),
+      _serverPort(0),
+      _status_code(200),
+      _loop(NULL),
+      _timers(NULL),
+      _timer(),
+      _files(NULL),
+      _content(NULL)
 
 {
+    _timer.data = this;
     _cgi_pipe_in[0] = _cgi_pipe_in[1] = -1;
     _cgi_pipe_out[0] = _cgi_pipe_out[1] = -1;
-
     DEBUG_PRINT("=== CLIENT CONSTRUCTED ===");
-    DEBUG_PRINT("Socket: " << _socket);
-    DEBUG_PRINT("Initial state: READING");
-    DEBUG_PRINT("Setting socket to non-blocking mode");
-
-    // Ensure socket is non-blocking
-    HttpServer::setNonBlocking(_socket);
 }
 
 Client::~Client()
 {
     DEBUG_PRINT(BLUE << "=== CLIENT DESTRUCTED ===" << RESET);
+    reset();
+}
+
+void Client::open(int fd, size_t serverIndex, int serverPort)
+{
+    _socket = fd;
+    _serverIndex = serverIndex;
+    _serverPort = serverPort;
+    _state = READING;
+    _parser.setMaxBodySize(_server.getServerMaxBodySize(serverIndex));
+    _parser.setBodyBufferSize(_server.getServerConfig(serverIndex).getClientBodyBufferSize());
+
+    DEBUG_PRINT("=== CLIENT OPENED ===");
     DEBUG_PRINT("Socket: " << _socket);
-    DEBUG_PRINT("Final state: " << (_state == CLOSING ? "CLOSING" : "UNKNOWN"));
-    DEBUG_PRINT("Cleaning up CGI pipes");
+    DEBUG_PRINT("Initial state: READING");
+    // The socket arrives non-blocking from HttpServer::acceptConnections()
+}
 
-    // Close CGI pipes if any
+// Empty a buffer for the next connection. Its capacity is kept unless one
+// large request or response blew it up.
+static void recycleBuffer(std::string &buf)
+{
+    if (buf.capacity() > CLIENT_BUFFER_KEEP)
+        std::string().swap(buf);
+    else
+        buf.clear();
+}
+
+void Client::reset()
+{
+    DEBUG_PRINT("Resetting client (socket: " << _socket << ", state: " << (_state == CLOSING ? "CLOSING" : "UNKNOWN") << ")");
+
+    if (_timers != NULL)
+        _timers->cancel(_timer);
+    _timers = NULL;
+
+    // Close CGI pipes and stop a CGI that is still running
     if (_cgi_pipe_in[0] != -1)
         close(_cgi_pipe_in[0]);
-    if (_cgi_pipe_in[1] != -1)
-        close(_cgi_pipe_in[1]);
-    if (_cgi_pipe_out[0] != -1)
-        close(_cgi_pipe_out[0]);
     if (_cgi_pipe_out[1] != -1)
         close(_cgi_pipe_out[1]);
+    _cgi_pipe_in[0] = _cgi_pipe_out[1] = -1;
+    cleanup_cgi();
+    _loop = NULL;
+    _files = NULL;
+    _content = NULL;
+
     // Delete response object if created
     if (_response != NULL)
     {
         delete _response;
         _response = NULL;
     }
+
+    _socket = -1;
+    _state = CLOSING;
+    _keep_alive = false;
+    _peer_half_closed = false;
+    _request_ready = false;
+    recycleBuffer(_request_buffer);
+    recycleBuffer(_cgi_output_buffer);
+    _output.clear();
+    _read_chunk = CLIENT_READ_CHUNK_MIN;
+    _bytes_read = 0;
+    _parser.reset(); // keeps the header buffer capacity
+    _cgi_handler = CGI();
+    _cgi_started = false;
+    _cgi_input_offset = 0;
+    _serverIndex = 0;
+    _serverPort = 0;
+    _status_code = 200;
+    _poll = PollRegistration();
 }
 
 int Client::getSocket() const { return _socket; }
@@ -101,7 +154,7 @@ void Client::handleConnection()
                                                                   : _state == CGI_READING_OUTPUT    ? "CGI_READING_OUTPUT"
                                                                   : _state == CGI_WRITING_INPUT     ? "CGI_WRITING_INPUT"
                                                                                                     : "UNKNOWN"));
-    checkCgiTimeout();
+    ClientState before = _state;
     switch (_state)
     {
     case READING:
@@ -123,97 +176,108 @@ void Client::handleConnection()
     default:
         break; // Server will close
     }
+    if (_state != before)
+        armTimer();
 }
 
-void Client::readRequest()
+// Read what the socket has straight into _request_buffer: recv() is repeated
+// until a short read shows the socket is drained, or until the fairness
+// budget is used up so one fast upload cannot starve the other connections.
+// The read size doubles while reads fill it. Returns the bytes read, or the
+// result of the first recv() (0 = EOF, -1 = error) if nothing was read.
+ssize_t Client::receive()
 {
-    DEBUG_PRINT(BLUE << "=== READING REQUEST ===" << RESET);
-    DEBUG_PRINT("Buffer size before reading: " << _request_buffer.size());
-
-    char buf[4096];
-    ssize_t n = recv(_socket, buf, sizeof(buf), 0);
-    if (n > 0)
+    size_t total = 0;
+    while (total < CLIENT_READ_BUDGET)
     {
-        updateLastActivityTime(); // Update activity on successful read
-        _request_buffer.append(buf, buf + n);
-        DEBUG_PRINT("Received " << n << " bytes, total buffer: " << _request_buffer.size());
-        size_t header_end = _request_buffer.find("\r\n\r\n");
-        DEBUG_PRINT(CYAN << "Current header end position: " << header_end << RESET);
-        if (header_end != std::string::npos)
+        size_t chunk = _read_chunk;
+        size_t used = _request_buffer.size();
+        _request_buffer.resize(used + chunk);
+        ssize_t n = recv(_socket, &_request_buffer[used], chunk, 0);
+        _request_buffer.resize(used + (n > 0 ? static_cast<size_t>(n) : 0));
+        if (n <= 0)
         {
-            // Check for Content-Length to read the body if present
-            size_t contentLength = checkContentLength(_request_buffer, header_end);
-            DEBUG_PRINT(CYAN << "Detected Content-Length: " << contentLength << RESET);
-            bool isChunked = hasChunked(_request_buffer, header_end);
-            if (contentLength > 0 || isChunked)
-            {
-                size_t maxBodySize = _server.getServerMaxBodySize(_serverIndex);
-                if (maxBodySize != 0 && contentLength > maxBodySize)
-                {
+            // After data was read, EOF or an error is seen again on the next
+            // wakeup; errno is not consulted to tell EAGAIN apart
+            if (total == 0)
+                return n;
+            break;
+        }
+        total += static_cast<size_t>(n);
+        if (static_cast<size_t>(n) < chunk)
+            break;
+        if (_read_chunk < CLIENT_READ_CHUNK_MAX)
+            _read_chunk *= 2;
+    }
+    _bytes_read += total;
+    return static_cast<ssize_t>(total);
+}
 
-                    DEBUG_PRINT(RED << "Warning:Request body exceeds maximum allowed size" << RESET);
-                    // Set status code, but continue reading to drain the socket
-                    _status_code = 413;
-                }
-                // Total length = header end position + 4 (for CRLF) + body
-                // size_t totalLength = header_end + 4 + contentLength;
+// Content-Length is known: read the rest of the body in as few recv() calls
+// as possible (the parser has sized its body buffer already)
+void Client::sizeForBody(size_t remaining)
+{
+    if (remaining == 0)
+        return;
+    if (remaining < CLIENT_READ_CHUNK_MIN)
+        remaining = CLIENT_READ_CHUNK_MIN;
+    _read_chunk = (remaining < CLIENT_READ_CHUNK_MAX) ? remaining : CLIENT_READ_CHUNK_MAX;
+}
 
-                // Check how many body bytes we have already
-                size_t have = 0;
-                if (_request_buffer.size() > header_end + 4)
-                    have = _request_buffer.size() - (header_end + 4);
+size_t Client::takeBytesRead()
+{
+    size_t n = _bytes_read;
+    _bytes_read = 0;
+    return n;
+}
 
-                if ((!isChunked && have < contentLength) || (isChunked && checkEnd(_request_buffer, header_end) == false))
-                {
-                    DEBUG_PRINT("Incomplete body: have " << have << " of " << contentLength << " bytes");
-                    if (_peer_half_closed)
-                    {
-                        DEBUG_PRINT("Peer half-closed, will attempt to parse incomplete request");
-                        // fall through to parse attempt
-                    }
-                    else
-                    {
-                        DEBUG_PRINT("Need more body data; staying in READING state");
-                        return; // wait for next event (socket becomes readable)
-                    }
-                }
-            }
-        }
-        else
-        {
-            // Headers incomplete, need more data
-            return;
-        }
-    }
-    if (n == 0)
+// Feed _request_buffer from offset start to the parser. It keeps its
+// position between calls and decides when the request is complete (and
+// whether the body is too large). What it consumed is dropped from
+// _request_buffer right away: the parser keeps the header section and the
+// body itself, so an upload is not held twice. Bytes after the end of the
+// request (the next pipelined one) stay. Returns true once it is framed.
+bool Client::feedParser(size_t start)
+{
+    HTTPparser::FeedResult res = _parser.feed(_request_buffer.data() + start, _request_buffer.size() - start);
+    _request_buffer.erase(0, start + _parser.getConsumed());
+    if (res == HTTPparser::HEADERS_COMPLETE)
+        sizeForBody(_parser.getRemainingBody());
+    if (res == HTTPparser::NEED_MORE || res == HTTPparser::HEADERS_COMPLETE)
+        return false;
+    // Complete, or malformed: the parser's status code makes it a 400
+    if (_parser.isBodyTooLarge())
     {
-        DEBUG_PRINT("Connection closed by peer");
+        DEBUG_PRINT(RED << "Warning:Request body exceeds maximum allowed size" << RESET);
+        _status_code = 413;
+    }
+    else if (_parser.getErrorStatusCode() == "500")
+        _status_code = 500; // the body could not be spooled to disk
+    Logger::logRequest(_parser.getHeaders().raw());
+    return true;
+}
 
-        // Check if we have valid HTTP headers before attempting to parse
-        size_t header_end = _request_buffer.find("\r\n\r\n");
-        if (header_end != std::string::npos)
-        {
-            // We have complete headers, mark half-close and try to parse
-            DEBUG_PRINT("Peer half-closed after sending headers; will attempt to parse");
-            _peer_half_closed = true;
-        }
-        else if (!_request_buffer.empty())
-        {
-            // Peer closed without sending complete headers
-            // This is likely TLS/SSL data or invalid HTTP - close immediately
-            DEBUG_PRINT("Peer closed without sending complete HTTP headers; closing connection");
-            _state = CLOSING;
-            return;
-        }
-        else
+// Only the bytes of this wakeup are fed to the parser
+void Client::readRequest()
+{
+    DEBUG_PRINT(BLUE << "=== READING REQUEST ===" << RESET);
+    DEBUG_PRINT("Buffer size before reading: " << _request_buffer.size());
+
+    ssize_t n = receive();
+    if (n > 0)
+    {
+        armTimer(); // Progress: restart the header timeout
+        DEBUG_PRINT("Received " << n << " bytes, total buffer: " << _request_buffer.size());
+        if (!feedParser(_request_buffer.size() - static_cast<size_t>(n)))
         {
-            // Empty buffer and peer closed - just close
-            DEBUG_PRINT("Peer closed with no data; closing connection");
-            _state = CLOSING;
-            return;
+            DEBUG_PRINT("Request incomplete; staying in READING state");
+            return; // wait for next event (socket becomes readable)
         }
+        DEBUG_PRINT("Request framed, transitioning to GENERATING_RESPONSE");
+        _state = GENERATING_RESPONSE;
+        return;
     }
-    else if (n < 0)
+    if (n < 0)
     {
         DEBUG_PRINT("Fatal read error: " << strerror(errno));
         // Fatal error
@@ -221,37 +285,28 @@ void Client::readRequest()
         return;
     }
 
-    DEBUG_PRINT("Finished reading, buffer size: " << _request_buffer.size());
-
-    // Simple heuristic: check if we have at least the header terminator
-    // The HTTPparser will handle detailed validation and body completeness
-    size_t header_end = _request_buffer.find("\r\n\r\n");
-    if (header_end == std::string::npos)
+    DEBUG_PRINT("Connection closed by peer");
+    if (!_parser.headersComplete())
     {
-        if (_peer_half_closed && !_request_buffer.empty())
-        {
-            DEBUG_PRINT("Peer half-closed; attempting to parse incomplete request");
-            _state = GENERATING_RESPONSE;
-            Logger::logRequest(_request_buffer);
-        }
-        else
-        {
-            DEBUG_PRINT("Headers not complete yet, need more data");
-        }
+        // Nothing, or no complete header section (likely TLS/SSL data or
+        // invalid HTTP): close immediately
+        DEBUG_PRINT("Peer closed without sending complete HTTP headers; closing connection");
+        _state = CLOSING;
         return;
     }
-
-    // Headers found - let HTTPparser determine if body is complete
-    // For now, we'll attempt to parse. HTTPparser will validate completeness.
-    DEBUG_PRINT("Headers found, transitioning to GENERATING_RESPONSE");
+    // Headers complete but the body is cut short: answer 400, then close
+    DEBUG_PRINT("Peer half-closed after sending headers; request is incomplete");
+    _peer_half_closed = true;
+    _parser.finish();
     _state = GENERATING_RESPONSE;
-    Logger::logRequest(_request_buffer);
+    Logger::logRequest(_parser.getHeaders().raw());
 }
 
 void Client::generateResponse()
 {
     bool ok = false;
     DEBUG_PRINT(BLUE << "=== GENERATING RESPONSE ===" << RESET);
+    _request_ready = false;
     DEBUG_PRINT("Request buffer size: " << _request_buffer.size());
 
     // Parse the HTTP request
@@ -259,17 +314,12 @@ void Client::generateResponse()
     if (_status_code != 200)
     {
         DEBUG_PRINT(RED << "Skipping parsing due to pre-set error code: " << _status_code << RESET);
-        _keep_alive = false; // Always close on bad request
     }
     else
-    {
-        ok = _parser.parseRequest(_request_buffer);
-        _keep_alive = _server.determineKeepAlive(_parser);
-    }
+        ok = _parser.isValid(); // parsed while reading
 
     DEBUG_PRINT("Parsing result: " << (ok ? "SUCCESS" : "FAILED"));
     DEBUG_PRINT("Parser valid: " << (_parser.isValid() ? "YES" : "NO"));
-    DEBUG_PRINT("Keep-alive: " << (_keep_alive ? "YES" : "NO"));
 
     DEBUG_PRINT(MAGENTA << "*** EXITING HTTP PARSER ***" << RESET);
     if (_response != NULL)
@@ -278,25 +328,22 @@ void Client::generateResponse()
         _response = NULL;
     }
     // Response object must be created regardless of whether parsing is successful or not, to handle error responses
-    _response = new Response(_server, _parser, _server._configParser, _serverIndex);
+    _response = new Response(_server, _parser, _server._configParser, _serverIndex, *_files, *_content);
     if (ok && _parser.isValid())
     {
         DEBUG_PRINT(GREEN << "Request parsed successfully" << RESET);
 
-        const std::string path = _parser.getPath();
-
         // Map location and resolve filesystem path for this request
-        std::string filePath = _server.resolveFilePathFor(path, _serverIndex);
-        _parser.setCurrentFilePath(filePath);
+        std::string filePath = _server.resolveFilePathFor(_parser, _serverIndex);
         DEBUG_PRINT("Resolved file path: '" << filePath << "'");
 
         // CGI handling requires proper location and method checks
-        const LocationConfig *loc = _server.getCurrentLocation();
+        const LocationConfig *loc = _parser.getCurrentLocation();
         bool cgiEnabled = (loc && loc->cgiPass);
-        std::string method = _parser.getMethod();
-        bool methodAllowed = _server.isMethodAllowed(method);
+        HTTPMethod method = _parser.getMethodId();
+        bool methodAllowed = _server.isMethodAllowed(loc, _parser.getMethod());
 
-        if (methodAllowed && (method == "POST" || method == "DELETE") && cgiEnabled)
+        if (methodAllowed && (method == METHOD_POST || method == METHOD_DELETE) && cgiEnabled)
         {
             // Check if file extension matches CGI extension
             bool isCgiScript = false;
@@ -309,31 +356,19 @@ void Client::generateResponse()
                     isCgiScript = (ext == loc->cgiExtension);
                 }
             }
+            if (isCgiScript && !_output.empty())
+            {
+                // Answers to earlier pipelined requests go out before the
+                // script runs; this request is generated again afterwards
+                DEBUG_PRINT("Flushing queued responses before starting CGI");
+                _request_ready = true;
+                _state = WRITING;
+                return;
+            }
             if (isCgiScript)
             {
                 DEBUG_PRINT(CYAN << "Starting non-blocking CGI" << RESET);
 
-                // === If peer half-closed and body incomplete, DO NOT start CGI ===
-                std::string cl_hdr = _parser.getHeader("Content-Length");
-                if (_peer_half_closed && !cl_hdr.empty())
-                {
-                    size_t expected = 0;
-                    std::istringstream iss(cl_hdr);
-                    iss >> expected;
-                    if (_parser.getBody().size() < expected)
-                    {
-                        DEBUG_PRINT(RED << "Peer half-closed with incomplete body; aborting CGI" << RESET);
-                        _status_code = 400;
-                        if (_response)
-                            _response_buffer = _response->processResponse(_parser.getMethod(), _status_code, "");
-                        Logger::logResponse(_response_buffer);
-                        _response_offset = 0;
-                        DEBUG_PRINT("Transitioning to WRITING state");
-                        _state = WRITING;
-                        return;
-                    }
-                }
-
                 // Create CGI handler
                 _cgi_handler = CGI(_parser);
 
@@ -343,13 +378,17 @@ void Client::generateResponse()
                     _cgi_pid = _cgi_handler.getPid();
                     _cgi_pipe_in[1] = _cgi_handler.getInputFd();
                     _cgi_pipe_out[0] = _cgi_handler.getOutputFd();
+                    _cgi_handler.releasePipes(); // the Client closes them from now on
                     _cgi_input_offset = 0;
                     _cgi_output_buffer.clear();
                     _cgi_started = true;
-                    _cgi_start_time = time(NULL); // NEW
+                    // cgi_timeout bounds the whole run; CGI pipe progress does not re-arm it
+                    if (_timers != NULL)
+                        _timers->arm(_timer, _server.getServerConfig(_serverIndex).getCgiTimeout());
 
-                    // Transition to writing input state
-                    _state = CGI_WRITING_INPUT;
+                    // A spooled body is the script's stdin already: only
+                    // a body in memory goes through the input pipe
+                    _state = (_cgi_pipe_in[1] != -1) ? CGI_WRITING_INPUT : CGI_READING_OUTPUT;
                     DEBUG_PRINT("CGI forked successfully, PID: " << _cgi_pid);
                 }
                 else
@@ -369,89 +408,66 @@ void Client::generateResponse()
     // If we reach here, either parsing failed, error occurred or we are not doing CGI
     // If parsing failed, parser would have set error status code which will be checked inside processResponse
     if (_response)
-        _response_buffer = _response->processResponse(_parser.getMethod(), _status_code, "");
-    Logger::logResponse(_response_buffer);
-    _response_offset = 0;
+        _response->processResponse(_parser.getMethod(), _status_code, "");
+    queueResponse();
+}
+
+// Append the response of the current request to the output and move on to
+// the next request. If a pipelined request is already in _request_buffer it
+// is answered right away (GENERATING_RESPONSE again), so the responses go
+// out in order and together, up to CLIENT_PIPELINE_FLUSH bytes per batch.
+// The response decides whether the connection stays open (the one that
+// wrote its Connection header); if not, bytes behind the request are never
+// parsed.
+void Client::queueResponse()
+{
+    _keep_alive = _response != NULL && _response->keepAlive();
+    DEBUG_PRINT("Keep-alive: " << (_keep_alive ? "YES" : "NO"));
+    if (_response != NULL)
+        _response->takeOutput(_output);
     DEBUG_PRINT("Transitioning to WRITING state");
     _state = WRITING;
-    return;
+    if (!_keep_alive || _peer_half_closed)
+        return; // the connection closes after this response
+    nextRequest();
+    if (_request_ready && _output.size() < CLIENT_PIPELINE_FLUSH)
+        _state = GENERATING_RESPONSE;
+}
+
+// Start on the next request of a keep-alive connection: parse the bytes
+// that arrived behind the previous one
+void Client::nextRequest()
+{
+    _parser.reset();
+    _status_code = 200;
+    _read_chunk = CLIENT_READ_CHUNK_MIN;
+    _request_ready = !_request_buffer.empty() && feedParser(0);
 }
 
 void Client::writeResponse()
 {
     DEBUG_PRINT(BLUE << "=== WRITING RESPONSE ===" << RESET);
-    DEBUG_PRINT("Response buffer size: " << _response_buffer.size());
-    DEBUG_PRINT("Bytes already sent: " << _response_offset);
+    DEBUG_PRINT("Bytes queued: " << _output.size());
 
     // Check if response is already complete BEFORE attempting send
-    if (_response_offset >= _response_buffer.size())
+    if (_output.empty())
     {
         DEBUG_PRINT(BLUE << "Response fully sent, handling completion" << RESET);
-
-        // If the peer already half-closed its write side, close after sending
-        if (_peer_half_closed)
-        {
-            DEBUG_PRINT("Peer half-closed earlier; transitioning to CLOSING");
-            _state = CLOSING;
-            return;
-        }
-
-        if (_keep_alive)
-        {
-            DEBUG_PRINT("Keep-alive enabled, resetting for next request");
-            // Reset for next request
-            _request_buffer.clear();
-            _response_buffer.clear();
-            _response_offset = 0;
-            _parser.reset();
-            _state = READING;
-        }
-        else
-        {
-            DEBUG_PRINT("Keep-alive disabled, transitioning to CLOSING");
-            _state = CLOSING;
-        }
+        responseSent();
         return;
     }
 
-    ssize_t sent = send(_socket,
-                        _response_buffer.c_str() + _response_offset,
-                        _response_buffer.size() - _response_offset,
-                        0);
-
+    ssize_t sent = _output.send(_socket);
     if (sent > 0)
     {
-        updateLastActivityTime(); // Update activity on successful write
-        _response_offset += static_cast<size_t>(sent);
-        DEBUG_PRINT("Sent " << sent << " bytes, progress: " << _response_offset << "/" << _response_buffer.size());
+        armTimer(); // Progress: restart the send timeout
+        DEBUG_PRINT("Sent " << sent << " bytes, " << _output.size() << " left");
 
         // Check if we just completed the response
-        if (_response_offset >= _response_buffer.size())
+        if (_output.empty())
         {
             DEBUG_PRINT(BLUE << "Response sending completed" << RESET);
-            DEBUG_PRINT("Total bytes sent: " << _response_offset);
-
-            if (_peer_half_closed)
-            {
-                DEBUG_PRINT("Peer half-closed earlier; transitioning to CLOSING");
-                _state = CLOSING;
-                return;
-            }
-
-            if (_keep_alive)
-            {
-                DEBUG_PRINT("Keep-alive enabled, resetting for next request");
-                _request_buffer.clear();
-                _response_buffer.clear();
-                _response_offset = 0;
-                _parser.reset();
-                _state = READING;
-            }
-            else
-            {
-                DEBUG_PRINT("Keep-alive disabled, transitioning to CLOSING");
-                _state = CLOSING;
-            }
+            responseSent();
         }
         else
         {
@@ -460,6 +476,7 @@ void Client::writeResponse()
     }
     else if (sent == 0)
     {
+        // Also a file that shrank: Content-Length cannot be kept
         DEBUG_PRINT("Send returned 0, connection likely closed");
         _state = CLOSING;
     }
@@ -470,82 +487,34 @@ void Client::writeResponse()
     }
 }
 
-size_t Client::checkContentLength(const std::string &request, size_t header_end)
+// Everything queued is sent. The next request was started when its
+// predecessor's response was queued (see queueResponse()).
+void Client::responseSent()
 {
-    size_t contentLength = 0;
-    size_t pos = request.find("Content-Length:", 0);
-    if (pos != std::string::npos && pos < header_end)
+    // If the peer already half-closed its write side, close after sending
+    if (_peer_half_closed)
     {
-        pos += 15; // length of "Content-Length:"
-        while (pos < header_end && (request[pos] == ' ' || request[pos] == '\t'))
-            ++pos;
-        size_t end = pos;
-        while (end < header_end && std::isdigit(request[end]))
-            ++end;
-        if (end > pos)
-        {
-            std::stringstream ss(request.substr(pos, end - pos));
-            ss >> contentLength;
-        }
+        DEBUG_PRINT("Peer half-closed earlier; transitioning to CLOSING");
+        _state = CLOSING;
     }
-    return contentLength;
-}
-
-// Return true if the header block contains Transfer-Encoding: chunked (case-insensitive)
-// This is a helper for determining if we need to look for chunked body while reading
-bool Client::hasChunked(const std::string &request, size_t header_end) const
-{
-    size_t pos = request.find("Transfer-Encoding:", 0);
-    if (pos == std::string::npos || pos >= header_end)
-        return false;
-    pos += strlen("Transfer-Encoding:");
-    while (pos < header_end && (request[pos] == ' ' || request[pos] == '\t'))
-        ++pos;
-    size_t end = pos;
-    while (end < header_end && request[end] != '\r' && request[end] != '\n')
-        ++end;
-    std::string val = request.substr(pos, end - pos);
-    // lowercase check for "chunked"
-    for (size_t i = 0; i < val.size(); ++i)
-        val[i] = static_cast<char>(::tolower(val[i]));
-    return (val.find("chunked") != std::string::npos);
-}
-
-// Quick heuristic: look for common final-zero-chunk patterns.
-// Returns true if it very likely contains the terminating 0-chunk (+ optional trailers).
-bool Client::checkEnd(const std::string &request, size_t header_end) const
-{
-    if (header_end == std::string::npos)
-        return false;
-    size_t body_start = header_end + 4; // after "\r\n\r\n"
-    if (body_start >= request.size())
-        return false;
-
-    // common full terminator: CRLF "0" CRLF CRLF
-    if (request.find("\r\n0\r\n\r\n", body_start) != std::string::npos)
-        return true;
-
-    // common terminator without trailing blank line (some clients)
-    if (request.find("\r\n0\r\n", body_start) != std::string::npos)
-        return true;
-
-    // zero chunk may be at body_start (no preceding CRLF)
-    if (request.compare(body_start, 4, "0\r\n\r\n") == 0 || request.compare(body_start, 3, "0\r\n") == 0)
-        return true;
-
-    // chunk extensions: look for "\r\n0;" then CRLF and final CRLFCRLF afterwards
-    size_t p = request.find("\r\n0;", body_start);
-    if (p != std::string::npos)
+    else if (!_keep_alive)
     {
-        size_t afterSizeLine = request.find("\r\n", p + 3);
-        if (afterSizeLine != std::string::npos)
-        {
-            if (request.find("\r\n\r\n", afterSizeLine + 2) != std::string::npos)
-                return true;
-        }
+        DEBUG_PRINT("Keep-alive disabled, transitioning to CLOSING");
+        _state = CLOSING;
+    }
+    else if (_request_ready)
+    {
+        DEBUG_PRINT("Pipelined request waiting, generating its response");
+        _state = GENERATING_RESPONSE;
+    }
+    else
+    {
+        DEBUG_PRINT("Keep-alive enabled, waiting for the next request");
+        // Idle until the next request: give large buffers back. The parser
+        // consumed every byte of a partial request, so nothing is lost.
+        recycleBuffer(_request_buffer);
+        _state = READING;
     }
-
-    return false;
 }
 
 // Write request body to CGI incrementally
@@ -561,8 +530,7 @@ void Client::writeToCgi()
     if (_cgi_input_offset >= body_size)
     {
         DEBUG_PRINT(GREEN << "Finished writing request body to CGI" << RESET);
-        close(_cgi_pipe_in[1]);
-        _cgi_pipe_in[1] = -1;
+        closeCgiPipe(_cgi_pipe_in[1]);
         _state = CGI_READING_OUTPUT;
         return;
     }
@@ -583,8 +551,7 @@ void Client::writeToCgi()
         if (_cgi_input_offset >= body_size)
         {
             DEBUG_PRINT(GREEN << "Finished writing request body to CGI" << RESET);
-            close(_cgi_pipe_in[1]);
-            _cgi_pipe_in[1] = -1;
+            closeCgiPipe(_cgi_pipe_in[1]);
             _state = CGI_READING_OUTPUT;
         }
         // Otherwise, stay in CGI_WRITING_INPUT and return to select()
@@ -603,9 +570,10 @@ void Client::writeToCgi()
         DEBUG_PRINT(RED << "Error writing to CGI, aborting" << RESET);
         _status_code = 400;
         if (_response)
-            _response_buffer = _response->processResponse(_parser.getMethod(), _status_code, "");
-        Logger::logResponse(_response_buffer);
-        _response_offset = 0;
+        {
+            _response->processResponse(_parser.getMethod(), _status_code, "");
+            _response->takeOutput(_output);
+        }
         DEBUG_PRINT("Transitioning to WRITING state");
         _state = WRITING;
         cleanup_cgi();
@@ -614,8 +582,7 @@ void Client::writeToCgi()
 
     // Finished writing input to CGI
     DEBUG_PRINT(GREEN << "Finished writing request body to CGI" << RESET);
-    close(_cgi_pipe_in[1]);
-    _cgi_pipe_in[1] = -1;
+    closeCgiPipe(_cgi_pipe_in[1]);
 
     // Transition to reading output from CGI
     _state = CGI_READING_OUTPUT;
@@ -638,8 +605,7 @@ void Client::readFromCgi()
     {
         // EOF - CGI finished writing
         DEBUG_PRINT(GREEN << "CGI output pipe closed, finished reading" << RESET);
-        close(_cgi_pipe_out[0]);
-        _cgi_pipe_out[0] = -1;
+        closeCgiPipe(_cgi_pipe_out[0]);
 
         int status;
         pid_t result = waitpid(_cgi_pid, &status, WNOHANG);
@@ -656,7 +622,6 @@ void Client::readFromCgi()
             {
                 DEBUG_PRINT(RED << "CGI failed with exit status " << status << RESET);
                 _status_code = 500;
-                _keep_alive = false;
             }
         }
         else if (result == 0)
@@ -682,32 +647,32 @@ void Client::readFromCgi()
         DEBUG_PRINT(RED << "Error reading from CGI, aborting" << RESET);
         _status_code = 400;
     }
-    if (_response)
-    {
-        _response_buffer = _response->processResponse(_parser.getMethod(), _status_code, _cgi_output_buffer);
-    }
-    Logger::logResponse(_response_buffer);
-    _response_offset = 0;
-    DEBUG_PRINT("Transitioning to WRITING state");
-    _state = WRITING;
-    updateLastActivityTime(); // Reset timeout timer after CGI finishes
     cleanup_cgi();
+    if (_response)
+        _response->processResponse(_parser.getMethod(), _status_code, _cgi_output_buffer);
+    queueResponse();
+}
+
+// Drop a CGI pipe from the event loop, then close it. The order matters with
+// reactor threads: a CGI forked by another thread briefly holds a copy of the
+// pipe, and epoll keeps reporting a registration whose file is still open
+// under a descriptor number this thread may already have reused.
+void Client::closeCgiPipe(int &fd)
+{
+    if (fd == -1)
+        return;
+    if (_loop != NULL)
+        _loop->remove(fd);
+    close(fd);
+    fd = -1;
 }
 
 void Client::cleanup_cgi()
 {
     DEBUG_PRINT(BLUE << "=== CLEANING UP CGI ===" << RESET);
 
-    if (_cgi_pipe_in[1] != -1)
-    {
-        close(_cgi_pipe_in[1]);
-        _cgi_pipe_in[1] = -1;
-    }
-    if (_cgi_pipe_out[0] != -1)
-    {
-        close(_cgi_pipe_out[0]);
-        _cgi_pipe_out[0] = -1;
-    }
+    closeCgiPipe(_cgi_pipe_in[1]);
+    closeCgiPipe(_cgi_pipe_out[0]);
     if (_cgi_pid != -1)
     {
         kill(_cgi_pid, SIGKILL);
@@ -716,39 +681,59 @@ void Client::cleanup_cgi()
     }
 }
 
-void Client::checkCgiTimeout() // NEW
+void Client::setTimerWheel(TimerWheel *wheel)
 {
-    // Guard clause: Return immediately if no CGI process is running
-    if (_cgi_pid == -1 || (_state != CGI_WRITING_INPUT && _state != CGI_READING_OUTPUT))
-        return;
+    if (_timers != NULL)
+        _timers->cancel(_timer);
+    _timers = wheel;
+}
 
-    // Check timeout
-    if (difftime(time(NULL), _cgi_start_time) > CGI_TIMEOUT)
+// Arm the timeout that applies to the current state:
+//   READING  keepalive_timeout between requests, client_header_timeout
+//            once the first byte of a request arrived (re-armed per read)
+//   WRITING  send_timeout, re-armed whenever the peer accepts more data
+//   CGI_*    cgi_timeout, armed once when the script is started
+void Client::armTimer()
+{
+    if (_timers == NULL)
+        return;
+    const ServerConfig &conf = _server.getServerConfig(_serverIndex);
+    switch (_state)
     {
-        DEBUG_PRINT(RED << "CGI timed out after " << CGI_TIMEOUT << " seconds" << RESET);
-        cleanup_cgi();
-        _status_code = 504; // Gateway Timeout
-        
-        if (_response)
-            _response_buffer = _response->processResponse(_parser.getMethod(), _status_code, "");
-            
-        Logger::logResponse(_response_buffer);
-        _response_offset = 0;
-        _state = WRITING;
-        updateLastActivityTime(); // Reset timeout timer after CGI timeout
+    case READING:
+        if (_request_buffer.empty() && !_parser.hasStarted() && _keep_alive)
+            _timers->arm(_timer, conf.getKeepaliveTimeout());
+        else
+            _timers->arm(_timer, conf.getClientHeaderTimeout());
+        break;
+    case WRITING:
+        _timers->arm(_timer, conf.getSendTimeout());
+        break;
+    case CGI_WRITING_INPUT:
+    case CGI_READING_OUTPUT:
+        break; // keeps the cgi_timeout armed in generateResponse()
+    default:
+        _timers->cancel(_timer);
+        break;
     }
 }
 
-void Client::updateLastActivityTime()
+void Client::handleTimeout()
 {
-    _last_activity_time = time(NULL);
-}
+    if (_state != CGI_WRITING_INPUT && _state != CGI_READING_OUTPUT)
+    {
+        DEBUG_PRINT(RED << "Client timed out (socket: " << _socket << ")" << RESET);
+        // An idle connection is closed without a response (no 408)
+        _state = CLOSING;
+        return;
+    }
 
-bool Client::hasTimedOut() const
-{
-    // Do not timeout if we are waiting for CGI or generating response
-    if (_state == CGI_WRITING_INPUT || _state == CGI_READING_OUTPUT || _state == GENERATING_RESPONSE)
-        return false;
-        
-    return (difftime(time(NULL), _last_activity_time) > CLIENT_TIMEOUT);
+    DEBUG_PRINT(RED << "CGI timed out after " << _server.getServerConfig(_serverIndex).getCgiTimeout() << " ms" << RESET);
+    cleanup_cgi();
+    _status_code = 504; // Gateway Timeout
+
+    if (_response)
+        _response->processResponse(_parser.getMethod(), _status_code, "");
+    queueResponse();
+    armTimer();
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "ClientPool.hpp"
+#include "Client.hpp"
+
+ClientPool::ClientPool(const HttpServer &server)
+    : _server(server), _capacity(0), _inUse(0), _hits(0), _misses(0)
+{
+}
+
+ClientPool::~ClientPool()
+{
+    for (size_t i = 0; i < _free.size(); ++i)
+        delete _free[i];
+}
+
+void ClientPool::reserve(size_t capacity)
+{
+    _capacity = capacity;
+    _free.reserve(capacity);
+    while (_free.size() + _inUse < capacity)
+        _free.push_back(new Client(_server));
+}
+
+Client *ClientPool::acquire(int fd, size_t serverIndex, int serverPort)
+{
+    Client *cl;
+    if (!_free.empty())
+    {
+        cl = _free.back();
+        _free.pop_back();
+        ++_hits;
+    }
+    else
+    {
+        cl = new Client(_server);
+        ++_misses;
+    }
+    ++_inUse;
+    cl->open(fd, serverIndex, serverPort);
+    return cl;
+}
+
+void ClientPool::release(Client *cl)
+{
+    --_inUse;
+    if (_free.size() >= _capacity)
+    {
+        delete cl;
+        return;
+    }
+    cl->reset();
+    _free.push_back(cl);
+}
@@ -1,37 +1,64 @@
 #include "Common.hpp"
 #include "Cgi.hpp"
 
-bool HttpServer::determineKeepAlive(const HTTPparser &parser)
+// Whether the Connection header lists token (case-insensitive)
+static bool hasConnectionToken(const std::string &conn, const char *token)
 {
-    std::string conn = parser.getHeader("Connection");
-    std::string version = parser.getVersion();
-    // Normalize connection header to lowercase
-    for (size_t i = 0; i < conn.size(); ++i)
-        conn[i] = static_cast<char>(std::tolower(conn[i]));
+    size_t pos = 0;
+    while (pos <= conn.size())
+    {
+        size_t end = conn.find(',', pos);
+        if (end == std::string::npos)
+            end = conn.size();
+        size_t first = pos;
+        size_t last = end;
+        while (first < last && (conn[first] == ' ' || conn[first] == '\t'))
+            ++first;
+        while (last > first && (conn[last - 1] == ' ' || conn[last - 1] == '\t'))
+            --last;
+        if (HTTPValidation::equalsIgnoreCase(conn.data() + first, last - first, token))
+            return true;
+        pos = end + 1;
+    }
+    return false;
+}
 
-    DEBUG_PRINT("Determining keep-alive: Connection='" << conn << "', Version='" << version << "'");
+// Whether the request allows the connection to stay open: never after a
+// request that could not be parsed (where the next one starts is unknown),
+// not with "Connection: close", and on HTTP/1.0 only with "keep-alive".
+// Response::keepAlive() adds the status code; the Connection header and
+// the Client both follow that one decision.
+bool HttpServer::determineKeepAlive(const HTTPparser &parser) const
+{
+    if (!parser.isValid())
+    {
+        DEBUG_PRINT("Keep-alive: NO (request not parsed)");
+        return false;
+    }
+    std::string conn = parser.getHeader("Connection");
+    DEBUG_PRINT("Determining keep-alive: Connection='" << conn << "', Version='" << parser.getVersion() << "'");
 
-    if (conn.empty())
+    if (hasConnectionToken(conn, "close"))
     {
-        DEBUG_PRINT("Keep-alive: NO (HTTP/1.0 without explicit Connection header)");
-        return false; // Explicit keep-alive required for HTTP/1.0
+        DEBUG_PRINT("Keep-alive: NO (Connection: close)");
+        return false;
     }
-    else if (version == "HTTP/1.1")
+    if (parser.getVersionId() == HTTP_1_1)
     {
         DEBUG_PRINT("Keep-alive: YES (HTTP/1.1 default)");
         return true; // Default keep-alive for HTTP/1.1
     }
-
-    DEBUG_PRINT("Keep-alive: NO (HTTP/1.0 with Connection header but not 1.1)");
-    return false;
+    bool keep = hasConnectionToken(conn, "keep-alive");
+    DEBUG_PRINT("Keep-alive: " << (keep ? "YES" : "NO") << " (HTTP/1.0)");
+    return keep; // Explicit keep-alive required for HTTP/1.0
 }
 
-// Check if the method is allowed in the current location
-// Returns false if no location is set or method is not allowed
-bool HttpServer::isMethodAllowed(const std::string &method)
+// Check if the method is allowed in the location matched for the request
+// Returns false if no location matched or method is not allowed
+bool HttpServer::isMethodAllowed(const LocationConfig *loc, const std::string &method) const
 {
-    if (!_currentLocation)
+    if (!loc)
         return false;
 
-    return _currentLocation->allowedMethods.find(method) != _currentLocation->allowedMethods.end();
+    return loc->allowedMethods.find(method) != loc->allowedMethods.end();
 }
\ No newline at end of file
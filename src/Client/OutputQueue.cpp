@@ -0,0 +1,141 @@
+#include "OutputQueue.hpp"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+OutputQueue::OutputQueue() : _size(0)
+{
+}
+
+OutputQueue::~OutputQueue()
+{
+    clear();
+}
+
+void OutputQueue::push(std::string &data)
+{
+    if (data.empty())
+        return;
+    _segments.push_back(Segment());
+    _segments.back().data.swap(data);
+    _size += static_cast<off_t>(_segments.back().data.size());
+}
+
+void OutputQueue::push(ContentCache::Entry *entry)
+{
+    _segments.push_back(Segment());
+    _segments.back().entry = entry;
+    _size += static_cast<off_t>(entry->data().size());
+}
+
+void OutputQueue::pushFile(int fd, off_t size)
+{
+    _segments.push_back(Segment());
+    _segments.back().fd = fd;
+    _segments.back().fileEnd = size;
+    _size += size;
+}
+
+ssize_t OutputQueue::send(int socket)
+{
+    if (_segments.front().fd != -1)
+        return sendFile(socket);
+    return sendMemory(socket);
+}
+
+void OutputQueue::clear()
+{
+    while (!_segments.empty())
+        popFront();
+    _size = 0;
+}
+
+const std::string &OutputQueue::memory(const Segment &s)
+{
+    return s.entry != NULL ? s.entry->data() : s.data;
+}
+
+// The memory segments up to the next file, in one sendmsg()
+ssize_t OutputQueue::sendMemory(int socket)
+{
+    struct iovec iov[OUTPUT_IOV_MAX];
+    size_t count = 0;
+    for (; count < _segments.size() && count < OUTPUT_IOV_MAX && _segments[count].fd == -1; ++count)
+    {
+        const Segment &s = _segments[count];
+        const std::string &data = memory(s);
+        iov[count].iov_base = const_cast<char *>(data.data() + s.sent);
+        iov[count].iov_len = data.size() - s.sent;
+    }
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    int flags = 0;
+#ifdef MSG_MORE
+    if (count < _segments.size() && _segments[count].fd != -1)
+        flags = MSG_MORE; // the headers may share a segment with the file
+#endif
+    ssize_t sent = sendmsg(socket, &msg, flags);
+    if (sent <= 0)
+        return sent;
+
+    _size -= sent;
+    size_t left = static_cast<size_t>(sent);
+    while (left > 0)
+    {
+        Segment &s = _segments.front();
+        size_t rest = memory(s).size() - s.sent;
+        if (left < rest)
+        {
+            s.sent += left;
+            break;
+        }
+        left -= rest;
+        s.sent += rest;
+        popFront();
+    }
+    return sent;
+}
+
+// Send from the file at the front. sendfile() keeps the file in the
+// kernel; elsewhere one buffer of it goes through userspace.
+ssize_t OutputQueue::sendFile(int socket)
+{
+    Segment &s = _segments.front();
+    size_t count = static_cast<size_t>(s.fileEnd - s.fileOffset);
+#ifdef __linux__
+    ssize_t sent = sendfile(socket, s.fd, &s.fileOffset, count);
+#else
+    char buf[64 * 1024];
+    ssize_t sent = pread(s.fd, buf, std::min(count, sizeof(buf)), s.fileOffset);
+    if (sent > 0)
+        sent = ::send(socket, buf, static_cast<size_t>(sent), 0);
+    if (sent > 0)
+        s.fileOffset += sent;
+#endif
+    if (sent <= 0)
+        return sent; // 0: the file shrank, Content-Length cannot be kept
+    _size -= sent;
+    if (s.fileOffset >= s.fileEnd)
+        popFront();
+    return sent;
+}
+
+// Drop the front segment; what it had left to send no longer counts
+void OutputQueue::popFront()
+{
+    Segment &s = _segments.front();
+    _size -= static_cast<off_t>(memory(s).size() - s.sent) + (s.fileEnd - s.fileOffset);
+    if (s.entry != NULL)
+        ContentCache::release(s.entry);
+    if (s.fd != -1)
+        close(s.fd);
+    _segments.pop_front();
+}
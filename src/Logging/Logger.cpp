@@ -14,7 +14,9 @@ static std::string twoDigits(int v) {
 /// Returns a string representing the current timestamp in the format "[YYYY-MM-DD HH:MM:SS]"
 std::string Logger::timestamp() {
     std::time_t t = std::time(NULL);
-    std::tm *lt = std::localtime(&t);
+    std::tm tmBuf;
+    // localtime() returns a shared static buffer; reactor threads log concurrently
+    std::tm *lt = localtime_r(&t, &tmBuf);
 
     std::string ts = "[";
     ts += twoDigits(1900 + lt->tm_year);
@@ -34,11 +36,11 @@ std::string Logger::timestamp() {
 
 
 
-static void printLine(const std::string &prefix, const std::string &raw) {
+static void printLine(const std::string &prefix, const std::string &raw, const std::string &more = std::string()) {
 #ifdef DEBUG
-    std::cout << RED << prefix << " " << RESET << raw << std::endl;
+    std::cout << RED << prefix << " " << RESET << raw << more << std::endl;
 #else
-    (void)prefix; (void)raw;
+    (void)prefix; (void)raw; (void)more;
 #endif
 }
 
@@ -48,4 +50,18 @@ void Logger::logRequest(const std::string &raw) {
 
 void Logger::logResponse(const std::string &raw) {
     printLine(timestamp() + " [RESPONSE]", raw);
+}
+
+void Logger::logResponse(const std::string &raw, size_t len) {
+#ifdef DEBUG
+    std::cout << RED << timestamp() << " [RESPONSE] " << RESET;
+    std::cout.write(raw.data(), static_cast<std::streamsize>(len < raw.size() ? len : raw.size()));
+    std::cout << std::endl;
+#else
+    (void)raw; (void)len;
+#endif
+}
+
+void Logger::logResponse(const std::string &headers, const std::string &body) {
+    printLine(timestamp() + " [RESPONSE]", headers, body);
 }
\ No newline at end of file
@@ -16,6 +16,14 @@
 ConfigParser::ConfigParser()
     : _configFile(""), _root("html"), _index("index.html"), _clientMaxBodySize(1024 * 1024) // default 1 MiB
       ,
+      _workerProcesses(1),
+      _workerThreads(1),
+      _workerConnections(WORKER_CONNECTIONS_DEFAULT),
+      _openFileCacheMax(OPEN_FILE_CACHE_DEFAULT_MAX),
+      _openFileCacheInactiveMs(OPEN_FILE_CACHE_DEFAULT_INACTIVE_MS),
+      _openFileCacheValidMs(OPEN_FILE_CACHE_DEFAULT_VALID_MS),
+      _openFileCacheErrors(true),
+      _contentCacheSize(CONTENT_CACHE_DEFAULT_SIZE),
       _servers(),
       _lines()
 {
@@ -26,6 +34,14 @@ ConfigParser::ConfigParser()
       _root(other._root),
       _index(other._index),
       _clientMaxBodySize(other._clientMaxBodySize),
+      _workerProcesses(other._workerProcesses),
+      _workerThreads(other._workerThreads),
+      _workerConnections(other._workerConnections),
+      _openFileCacheMax(other._openFileCacheMax),
+      _openFileCacheInactiveMs(other._openFileCacheInactiveMs),
+      _openFileCacheValidMs(other._openFileCacheValidMs),
+      _openFileCacheErrors(other._openFileCacheErrors),
+      _contentCacheSize(other._contentCacheSize),
       _servers(other._servers),
       _lines(other._lines)
 {
@@ -35,6 +51,14 @@ ConfigParser::ConfigParser()
 ConfigParser::ConfigParser(const std::vector<std::string> &lines)
     : _configFile(""), _root("html"), _index("index.html"), _clientMaxBodySize(1024 * 1024) // default 1 MiB
       ,
+      _workerProcesses(1),
+      _workerThreads(1),
+      _workerConnections(WORKER_CONNECTIONS_DEFAULT),
+      _openFileCacheMax(OPEN_FILE_CACHE_DEFAULT_MAX),
+      _openFileCacheInactiveMs(OPEN_FILE_CACHE_DEFAULT_INACTIVE_MS),
+      _openFileCacheValidMs(OPEN_FILE_CACHE_DEFAULT_VALID_MS),
+      _openFileCacheErrors(true),
+      _contentCacheSize(CONTENT_CACHE_DEFAULT_SIZE),
       _servers(),
       _lines()
 {
@@ -164,6 +188,46 @@ size_t ConfigParser::getClientMaxBodySize() const
     return _clientMaxBodySize;
 }
 
+size_t ConfigParser::getWorkerProcesses() const
+{
+    return _workerProcesses;
+}
+
+size_t ConfigParser::getWorkerThreads() const
+{
+    return _workerThreads;
+}
+
+size_t ConfigParser::getWorkerConnections() const
+{
+    return _workerConnections;
+}
+
+size_t ConfigParser::getOpenFileCacheMax() const
+{
+    return _openFileCacheMax;
+}
+
+size_t ConfigParser::getOpenFileCacheInactiveMs() const
+{
+    return _openFileCacheInactiveMs;
+}
+
+size_t ConfigParser::getOpenFileCacheValidMs() const
+{
+    return _openFileCacheValidMs;
+}
+
+bool ConfigParser::getOpenFileCacheErrors() const
+{
+    return _openFileCacheErrors;
+}
+
+size_t ConfigParser::getContentCacheSize() const
+{
+    return _contentCacheSize;
+}
+
 const std::vector<ServerConfig> &ConfigParser::getServers() const
 {
     return _servers;
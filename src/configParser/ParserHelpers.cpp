@@ -51,6 +51,20 @@ void ConfigParser::handleDirective(const std::string &key, const std::string &va
         parseIndex(val, lineNo, &this->_index);
     else if (key == "client_max_body_size")
         parseClientMaxBodySize(val, lineNo);
+    else if (key == "worker_processes")
+        parseWorkerProcesses(val, lineNo);
+    else if (key == "worker_threads")
+        parseWorkerThreads(val, lineNo);
+    else if (key == "worker_connections")
+        parseWorkerConnections(val, lineNo);
+    else if (key == "open_file_cache")
+        parseOpenFileCache(val, lineNo);
+    else if (key == "open_file_cache_valid")
+        parseOpenFileCacheValid(val, lineNo);
+    else if (key == "open_file_cache_errors")
+        parseOpenFileCacheErrors(val, lineNo);
+    else if (key == "content_cache_size")
+        parseContentCacheSize(val, lineNo);
     else
     {
         // Unknown directive: ignore non-fatally for now
@@ -21,6 +21,56 @@ std::string ParserUtils::stripTrailingSemicolon(const std::string &line)
 	return line;
 }
 
+bool ParserUtils::parseDuration(const std::string &val, unsigned long maxMs, size_t &ms)
+{
+	size_t digits = 0;
+	while (digits < val.size() && std::isdigit(static_cast<unsigned char>(val[digits])))
+		++digits;
+	std::string suffix = val.substr(digits);
+
+	unsigned long unit = 0;
+	if (suffix.empty() || suffix == "s")
+		unit = 1000;
+	else if (suffix == "ms")
+		unit = 1;
+	else if (suffix == "m")
+		unit = 60 * 1000;
+	else if (suffix == "h")
+		unit = 60 * 60 * 1000;
+	else if (suffix == "d")
+		unit = 24 * 60 * 60 * 1000;
+
+	// More than 9 digits is out of range anyway and could overflow strtoul
+	unsigned long amount = std::strtoul(val.substr(0, digits).c_str(), NULL, 10);
+	if (digits == 0 || unit == 0 || digits > 9 || amount == 0 || amount > maxMs / unit)
+		return false;
+	ms = amount * unit;
+	return true;
+}
+
+bool ParserUtils::parseSize(const std::string &val, unsigned long max, size_t &bytes)
+{
+	size_t digits = 0;
+	while (digits < val.size() && std::isdigit(static_cast<unsigned char>(val[digits])))
+		++digits;
+	std::string suffix = val.substr(digits);
+
+	unsigned long unit = 0;
+	if (suffix.empty())
+		unit = 1;
+	else if (suffix == "k" || suffix == "K")
+		unit = 1024;
+	else if (suffix == "m" || suffix == "M")
+		unit = 1024 * 1024;
+
+	// More than 9 digits is out of range anyway and could overflow strtoul
+	unsigned long amount = std::strtoul(val.substr(0, digits).c_str(), NULL, 10);
+	if (digits == 0 || unit == 0 || digits > 9 || amount == 0 || amount > max / unit)
+		return false;
+	bytes = amount * unit;
+	return true;
+}
+
 bool ParserUtils::splitKeyVal(const std::string &line, std::string &key, std::string &val)
 {
 	std::string::size_type sp = line.find(' ');
@@ -0,0 +1,23 @@
+#include "Common.hpp"
+#include "ParserUtils.hpp"
+
+// Syntax: content_cache_size off | <size>;
+// Memory per event loop thread for the rendered responses of small static
+// files (see the content_cache location directive). Default 8m.
+void ConfigParser::parseContentCacheSize(const std::string &val, size_t lineNo)
+{
+    if (val == "off")
+    {
+        _contentCacheSize = 0;
+        DEBUG_PRINT("Disabled content_cache_size");
+        return;
+    }
+    if (!ParserUtils::parseSize(val, CONTENT_CACHE_SIZE_MAX, _contentCacheSize))
+    {
+        std::string msg = ErrorHandler::makeLocationMsg("Invalid value '" + val +
+                                                            "' for content_cache_size directive (expected 'off' or a positive size like 512k or 8m, at most 1024m)",
+                                                        (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+    DEBUG_PRINT("Set content_cache_size to " << _contentCacheSize << " bytes");
+}
@@ -0,0 +1,75 @@
+#include "Common.hpp"
+#include "ParserUtils.hpp"
+
+// Syntax: open_file_cache off | max=<N> [inactive=<time>];
+// Up to N lookups (open descriptors, stat() results and errors) are kept
+// per event loop thread; entries unused for 'inactive' (default 20s) are
+// closed. On by default with max=256.
+void ConfigParser::parseOpenFileCache(const std::string &val, size_t lineNo)
+{
+    if (val == "off")
+    {
+        _openFileCacheMax = 0;
+        DEBUG_PRINT("Disabled open_file_cache");
+        return;
+    }
+
+    std::istringstream iss(val);
+    std::string param;
+    bool valid = true;
+    bool haveMax = false;
+    while (valid && iss >> param)
+    {
+        if (param.compare(0, 4, "max=") == 0)
+        {
+            std::string num = param.substr(4);
+            valid = !num.empty() && num.size() <= 9 && num.find_first_not_of("0123456789") == std::string::npos;
+            _openFileCacheMax = valid ? std::strtoul(num.c_str(), NULL, 10) : 0;
+            valid = valid && _openFileCacheMax >= 1 && _openFileCacheMax <= OPEN_FILE_CACHE_MAX;
+            haveMax = true;
+        }
+        else if (param.compare(0, 9, "inactive=") == 0)
+            valid = ParserUtils::parseDuration(param.substr(9), OPEN_FILE_CACHE_TIME_MAX_MS, _openFileCacheInactiveMs);
+        else
+            valid = false;
+    }
+    if (!valid || !haveMax)
+    {
+        std::ostringstream oss;
+        oss << "Invalid value for open_file_cache (expected 'off' or max=1-" << OPEN_FILE_CACHE_MAX
+            << " [inactive=<time>]): " << val;
+        std::string msg = ErrorHandler::makeLocationMsg(oss.str(), (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+    DEBUG_PRINT("Set open_file_cache to max=" << _openFileCacheMax << " inactive=" << _openFileCacheInactiveMs << "ms");
+}
+
+// Syntax: open_file_cache_valid <time>;
+// How long a cached lookup is trusted before one stat() checks that the
+// file did not change (default 10s).
+void ConfigParser::parseOpenFileCacheValid(const std::string &val, size_t lineNo)
+{
+    if (!ParserUtils::parseDuration(val, OPEN_FILE_CACHE_TIME_MAX_MS, _openFileCacheValidMs))
+    {
+        std::string msg = ErrorHandler::makeLocationMsg("Invalid value '" + val +
+                                                            "' for open_file_cache_valid directive (expected a positive duration like 10s, 500ms or 2m, at most one day)",
+                                                        (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+    DEBUG_PRINT("Set open_file_cache_valid to " << _openFileCacheValidMs << " ms");
+}
+
+// Syntax: open_file_cache_errors on | off;
+// Whether failed lookups (missing files) are cached too (default on).
+void ConfigParser::parseOpenFileCacheErrors(const std::string &val, size_t lineNo)
+{
+    if (val != "on" && val != "off")
+    {
+        std::string msg = ErrorHandler::makeLocationMsg("Invalid value '" + val +
+                                                            "' for open_file_cache_errors directive (expected 'on' or 'off')",
+                                                        (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+    _openFileCacheErrors = (val == "on");
+    DEBUG_PRINT("Set open_file_cache_errors to " << val);
+}
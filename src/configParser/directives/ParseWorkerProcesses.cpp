@@ -0,0 +1,53 @@
+#include "Common.hpp"
+
+// Shared syntax of worker_processes and worker_threads: <N> | auto;
+// 'auto' means one worker per online CPU core.
+size_t ConfigParser::parseWorkerCount(const std::string &directive, const std::string &val, size_t max, size_t lineNo,
+                                      bool allowAuto) const
+{
+    if (allowAuto && val == "auto")
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        return (cpus > 0) ? static_cast<size_t>(cpus) : 1;
+    }
+
+    bool digitsOnly = !val.empty();
+    for (size_t i = 0; i < val.size(); ++i)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(val[i])))
+            digitsOnly = false;
+    }
+    long count = digitsOnly ? std::atol(val.c_str()) : 0;
+    if (count < 1 || static_cast<size_t>(count) > max)
+    {
+        std::ostringstream oss;
+        oss << "Invalid value for " << directive << " (expected 1-" << max << (allowAuto ? " or 'auto'" : "") << "): " << val;
+        std::string msg = ErrorHandler::makeLocationMsg(oss.str(), (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+    return static_cast<size_t>(count);
+}
+
+// Syntax: worker_processes <N> | auto;
+void ConfigParser::parseWorkerProcesses(const std::string &val, size_t lineNo)
+{
+    _workerProcesses = parseWorkerCount("worker_processes", val, WORKER_PROCESSES_MAX, lineNo);
+    DEBUG_PRINT("Set worker_processes to " << _workerProcesses);
+}
+
+// Syntax: worker_threads <N> | auto;
+void ConfigParser::parseWorkerThreads(const std::string &val, size_t lineNo)
+{
+    _workerThreads = parseWorkerCount("worker_threads", val, WORKER_THREADS_MAX, lineNo);
+    DEBUG_PRINT("Set worker_threads to " << _workerThreads);
+}
+
+// Syntax: worker_connections <N>;
+// Maximum number of open connections of each worker process; accepting
+// pauses at the limit. Also sizes the preallocated Client pools, which are
+// split evenly over the worker_threads reactors.
+void ConfigParser::parseWorkerConnections(const std::string &val, size_t lineNo)
+{
+    _workerConnections = parseWorkerCount("worker_connections", val, WORKER_CONNECTIONS_MAX, lineNo, false);
+    DEBUG_PRINT("Set worker_connections to " << _workerConnections);
+}
@@ -1,4 +1,5 @@
 #include "Common.hpp"
+#include "ParserUtils.hpp"
 
 void ServerConfig::applyAutoindex(LocationConfig *loc, const std::string &val, size_t lineNumber)
 {
@@ -91,6 +92,49 @@ void ServerConfig::applyRedirect(LocationConfig *loc, const std::string &val, si
 	DEBUG_PRINT("Set location redirect -> " << statusCode << " " << url);
 }
 
+// Syntax: content_cache off | <size>;
+// Responses for files up to size are kept rendered in memory (see
+// content_cache_size). Default 64k.
+void ServerConfig::applyContentCache(LocationConfig *loc, const std::string &val, size_t lineNumber)
+{
+	if (val == "off")
+		loc->contentCacheMax = 0;
+	else if (!ParserUtils::parseSize(val, CONTENT_CACHE_FILE_MAX, loc->contentCacheMax))
+	{
+		std::string msg = ErrorHandler::makeLocationMsg(
+			std::string("Invalid value for content_cache (expected 'off' or a file size like 64k, at most 16m): ") + val,
+			(int)lineNumber, this->_configFile);
+		throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE,
+									  (int)lineNumber, this->_configFile);
+	}
+	DEBUG_PRINT("Set location content_cache -> " << loc->contentCacheMax << " bytes");
+}
+
+// Syntax: expires off | epoch | max | <time>;
+// Cache-Control of static files: max-age=<time> (max is 10 years), or
+// no-cache for epoch. Default off (no header).
+void ServerConfig::applyExpires(LocationConfig *loc, const std::string &val, size_t lineNumber)
+{
+	size_t ms;
+	if (val == "off")
+		loc->expires = EXPIRES_OFF;
+	else if (val == "epoch")
+		loc->expires = EXPIRES_EPOCH;
+	else if (val == "max")
+		loc->expires = EXPIRES_MAX;
+	else if (ParserUtils::parseDuration(val, EXPIRES_MAX * 1000UL, ms))
+		loc->expires = static_cast<long>(ms / 1000);
+	else
+	{
+		std::string msg = ErrorHandler::makeLocationMsg(
+			std::string("Invalid value for expires (expected 'off', 'epoch', 'max' or a time like 1h or 30d): ") + val,
+			(int)lineNumber, this->_configFile);
+		throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE,
+									  (int)lineNumber, this->_configFile);
+	}
+	DEBUG_PRINT("Set location expires -> " << loc->expires);
+}
+
 // Handle location-specific directives
 void ServerConfig::handleLocationDirective(LocationConfig *currentLocation,
 										   const std::string &key,
@@ -111,6 +155,10 @@ void ServerConfig::handleLocationDirective(LocationConfig *currentLocation,
 		applyCgiExtension(currentLocation, val, lineNumber);
 	else if (key == "return")
 		applyRedirect(currentLocation, val, lineNumber);
+	else if (key == "content_cache")
+		applyContentCache(currentLocation, val, lineNumber);
+	else if (key == "expires")
+		applyExpires(currentLocation, val, lineNumber);
 	else
 	{
 		std::string msg = ErrorHandler::makeLocationMsg(
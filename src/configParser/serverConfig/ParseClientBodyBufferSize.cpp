@@ -0,0 +1,19 @@
+#include "Common.hpp"
+#include "ParserUtils.hpp"
+
+// Largest accepted client_body_buffer_size; bodies beyond it belong on disk
+#define CLIENT_BODY_BUFFER_MAX (64UL * 1024 * 1024)
+
+// Parses client_body_buffer_size: 8192, 16k or 1m. Request bodies larger
+// than this are written to an unlinked temporary file instead of memory.
+void ServerConfig::parseClientBodyBufferSize(const std::string &val, size_t lineNo)
+{
+    if (!ParserUtils::parseSize(val, CLIENT_BODY_BUFFER_MAX, _clientBodyBufferSize))
+    {
+        std::string msg = ErrorHandler::makeLocationMsg("Invalid value '" + val +
+                                                            "' for client_body_buffer_size directive (expected a positive size like 8192, 16k or 1m, at most 64m)",
+                                                        (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+    DEBUG_PRINT("Set client_body_buffer_size to " << _clientBodyBufferSize << " bytes");
+}
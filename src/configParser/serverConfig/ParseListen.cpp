@@ -1,10 +1,51 @@
 
 #include "Common.hpp"
 
+// Parses one parameter after the listen address:
+//   backlog=<n>  deferred  fastopen=<n>  reuseport
+void ServerConfig::parseListenOption(const std::string &option, size_t lineNo, ListenOptions *opts)
+{
+    std::string::size_type eq = option.find('=');
+    std::string name = option.substr(0, eq);
+    std::string value = (eq == std::string::npos) ? "" : option.substr(eq + 1);
+
+    bool numeric = !value.empty() && value.size() <= 9;
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(value[i])))
+            numeric = false;
+    }
+
+    if (name == "backlog" && numeric && std::atoi(value.c_str()) > 0)
+        opts->backlog = std::atoi(value.c_str());
+    else if (name == "fastopen" && numeric)
+        opts->fastopen = std::atoi(value.c_str());
+    else if (option == "deferred")
+        opts->deferred = true;
+    else if (option == "reuseport")
+        opts->reuseport = true;
+    else
+    {
+        std::string msg = ErrorHandler::makeLocationMsg("Invalid listen parameter '" + option +
+                                                            "' (expected backlog=<n>, deferred, fastopen=<n> or reuseport)",
+                                                        (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+}
+
+// Syntax: listen [host:]port [backlog=<n>] [deferred] [fastopen=<n>] [reuseport];
 void ServerConfig::parseListen(const std::string &val, size_t lineNo)
 {
-    std::string::size_type colonPos = val.rfind(':');
-    std::string portStr = (colonPos == std::string::npos) ? val : val.substr(colonPos + 1);
+    std::istringstream iss(val);
+    std::string address;
+    iss >> address;
+    ListenOptions opts;
+    std::string option;
+    while (iss >> option)
+        parseListenOption(option, lineNo, &opts);
+
+    std::string::size_type colonPos = address.rfind(':');
+    std::string portStr = (colonPos == std::string::npos) ? address : address.substr(colonPos + 1);
     int port = std::atoi(portStr.c_str());
 
     if (port <= 0)
@@ -18,7 +59,7 @@ void ServerConfig::parseListen(const std::string &val, size_t lineNo)
     std::string host = "0.0.0.0";
     if (colonPos != std::string::npos)
     {
-        std::string hostStr = trim(val.substr(0, colonPos));
+        std::string hostStr = trim(address.substr(0, colonPos));
         if (!hostStr.empty())
         {
             host = hostStr;
@@ -38,6 +79,7 @@ void ServerConfig::parseListen(const std::string &val, size_t lineNo)
 
     this->_hosts.push_back(host);
     this->_ports.push_back(port);
+    this->_listenOptions.push_back(opts);
 
     DEBUG_PRINT("Applied listen -> " << host << ":" << port);
     // DEBUG_PRINT("Total listen addresses: " << this->_listenAddresses.size());
@@ -0,0 +1,20 @@
+#include "Common.hpp"
+#include "ParserUtils.hpp"
+
+// Longest accepted timeout (one week); the timer wheel covers a bit more
+#define TIMEOUT_MAX_MS (7UL * 24 * 60 * 60 * 1000)
+
+// Parses client_header_timeout, keepalive_timeout, cgi_timeout and
+// send_timeout. Accepted formats: 10, 10s, 500ms, 2m (a bare number is in
+// seconds, like nginx); the value is stored in milliseconds.
+void ServerConfig::parseTimeout(const std::string &directive, const std::string &val, size_t lineNo, size_t *timeoutMs)
+{
+    if (!ParserUtils::parseDuration(val, TIMEOUT_MAX_MS, *timeoutMs))
+    {
+        std::string msg = ErrorHandler::makeLocationMsg("Invalid value '" + val + "' for " + directive +
+                                                            " directive (expected a positive duration like 10s, 500ms or 2m, at most one week)",
+                                                        (int)lineNo, this->_configFile);
+        throw ErrorHandler::Exception(msg, ErrorHandler::CONFIG_INVALID_DIRECTIVE, (int)lineNo, this->_configFile);
+    }
+    DEBUG_PRINT("Set " << directive << " to " << *timeoutMs << " ms");
+}
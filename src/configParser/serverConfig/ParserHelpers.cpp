@@ -47,10 +47,20 @@ void ServerConfig::handleDirective(const std::string &key, const std::string &va
         parseServerName(val, lineNo);
     else if (key == "client_max_body_size")
         parseClientMaxBodySize(val, lineNo);
+    else if (key == "client_body_buffer_size")
+        parseClientBodyBufferSize(val, lineNo);
     else if (key == "allowed_methods")
         parseAllowedMethods(val, lineNo, &this->_allowedMethods);
     else if (key == "error_page")
         parseErrorPage(val, lineNo);
+    else if (key == "client_header_timeout")
+        parseTimeout(key, val, lineNo, &this->_clientHeaderTimeout);
+    else if (key == "keepalive_timeout")
+        parseTimeout(key, val, lineNo, &this->_keepaliveTimeout);
+    else if (key == "cgi_timeout")
+        parseTimeout(key, val, lineNo, &this->_cgiTimeout);
+    else if (key == "send_timeout")
+        parseTimeout(key, val, lineNo, &this->_sendTimeout);
     else
     {
         // Unknown directive: ignore non-fatally for now
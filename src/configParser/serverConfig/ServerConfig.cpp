@@ -6,7 +6,9 @@
 
 // constructor
 ServerConfig::ServerConfig(const std::string &root, const std::string &index, size_t clientMaxBodySize)
-    : _configFile(""), _ports(), _hosts(), _root(root), _index(index), _serverName(""), _errorPage(), _clientMaxBodySize(clientMaxBodySize), _allowedMethods()
+    : _configFile(""), _ports(), _hosts(), _root(root), _index(index), _serverName(""), _errorPage(), _clientMaxBodySize(clientMaxBodySize),
+      _clientBodyBufferSize(DEFAULT_CLIENT_BODY_BUFFER_SIZE), _clientHeaderTimeout(DEFAULT_CLIENT_HEADER_TIMEOUT), _keepaliveTimeout(DEFAULT_KEEPALIVE_TIMEOUT),
+      _cgiTimeout(DEFAULT_CGI_TIMEOUT), _sendTimeout(DEFAULT_SEND_TIMEOUT), _allowedMethods()
 {
     // Default host to 127.0.0.1 (localhost)
     if (inet_pton(AF_INET, "127.0.0.1", &_host) != 1) {
@@ -19,7 +21,8 @@ ServerConfig::ServerConfig(const std::string &root, const std::string &index, si
 // construct from lines
 ServerConfig::ServerConfig(const std::string &root, const std::string &index, size_t clientMaxBodySize, const std::vector<std::string> &lines)
     : _configFile(""), _ports(), _hosts(), _root(root), _index(index), _serverName(""), _errorPage(), _clientMaxBodySize(clientMaxBodySize),
-      _allowedMethods()
+      _clientBodyBufferSize(DEFAULT_CLIENT_BODY_BUFFER_SIZE), _clientHeaderTimeout(DEFAULT_CLIENT_HEADER_TIMEOUT), _keepaliveTimeout(DEFAULT_KEEPALIVE_TIMEOUT),
+      _cgiTimeout(DEFAULT_CGI_TIMEOUT), _sendTimeout(DEFAULT_SEND_TIMEOUT), _allowedMethods()
 {
     parse(lines);
 }
@@ -109,6 +112,31 @@ size_t ServerConfig::getClientMaxBodySize() const
     return _clientMaxBodySize;
 }
 
+size_t ServerConfig::getClientBodyBufferSize() const
+{
+    return _clientBodyBufferSize;
+}
+
+size_t ServerConfig::getClientHeaderTimeout() const
+{
+    return _clientHeaderTimeout;
+}
+
+size_t ServerConfig::getKeepaliveTimeout() const
+{
+    return _keepaliveTimeout;
+}
+
+size_t ServerConfig::getCgiTimeout() const
+{
+    return _cgiTimeout;
+}
+
+size_t ServerConfig::getSendTimeout() const
+{
+    return _sendTimeout;
+}
+
 // Get first port for backward compatibility
 int ServerConfig::getListenPort() const
 {
@@ -127,6 +155,12 @@ const std::vector<std::string> &ServerConfig::getListenHosts() const
     return _hosts;
 }
 
+// Get the socket options of every listen entry (parallel to ports)
+const std::vector<ListenOptions> &ServerConfig::getListenOptions() const
+{
+    return _listenOptions;
+}
+
 const std::string &ServerConfig::getServerName() const
 {
     return _serverName;
@@ -0,0 +1,15 @@
+#include "HTTPScanner.hpp"
+#include <cstring>
+
+size_t HTTPScanner::findLineEnd(const char *data, size_t len, size_t &colon)
+{
+    const char *lf = static_cast<const char *>(std::memchr(data, '\n', len));
+    size_t end = lf ? static_cast<size_t>(lf - data) : len;
+    if (colon == std::string::npos)
+    {
+        const char *sep = static_cast<const char *>(std::memchr(data, ':', end));
+        if (sep != NULL)
+            colon = static_cast<size_t>(sep - data);
+    }
+    return end;
+}
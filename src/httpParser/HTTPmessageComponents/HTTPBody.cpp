@@ -11,86 +11,115 @@
 /* ************************************************************************** */
 
 #include "HTTPBody.hpp"
-#include "HTTPHeaders.hpp"
 #include "HTTPValidation.hpp"
 #include "Common.hpp"
-#include <vector>
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
-HTTPBody::HTTPBody()
-    : _isValid(false)
+// A chunk size needs at most this many hex digits; longer ones would
+// overflow size_t (leading zeros aside, which no client sends)
+#define CHUNK_SIZE_MAX_DIGITS (sizeof(size_t) * 2 - 1)
+
+HTTPBody::HTTPBody() : _fd(-1), _size(0), _bufferSize(0)
 {
     reset();
 }
 
 HTTPBody::~HTTPBody()
 {
+    reset();
 }
 
 void HTTPBody::reset()
 {
-    _body.clear();
-    _isValid = false;
+    if (_fd != -1)
+        close(_fd); // last reference: the kernel frees the file
+    _fd = -1;
+    _size = 0;
+    if (_body.capacity() > HTTP_BODY_KEEP)
+        std::string().swap(_body);
+    else
+        _body.clear();
     _errorMessage.clear();
 }
 
-void HTTPBody::setError(const std::string& message)
+bool HTTPBody::append(const char *data, size_t len)
 {
-    _isValid = false;
-    _errorMessage = message;
-    DEBUG_PRINT("HTTPBody error: " << message);
+    if (_fd == -1 && _bufferSize != 0 && _body.size() + len > _bufferSize && !spool())
+        return false;
+    if (_fd != -1)
+    {
+        if (!writeFile(data, len))
+            return false;
+    }
+    else
+        _body.append(data, len);
+    _size += len;
+    return true;
 }
 
-void HTTPBody::trimTrailingCR(std::string& line)
+void HTTPBody::reserve(size_t len)
 {
-    if (!line.empty() && line[line.size() - 1] == '\r')
-        line.erase(line.size() - 1);
+    if (_bufferSize == 0 || len <= _bufferSize)
+        _body.reserve(len);
 }
 
-bool HTTPBody::readExact(std::istringstream& iss, size_t length, std::string& out)
+// Move the body received so far to a new temporary file
+bool HTTPBody::spool()
 {
-    // Attempt to read exactly 'length' bytes from the stream. If fewer
-    // bytes are available (e.g., truncated request), return false.
-    if (length == 0)
+    char path[] = HTTP_BODY_TEMP_TEMPLATE;
+    _fd = mkostemp(path, O_CLOEXEC); // a CGI gets it as stdin only
+    if (_fd == -1)
     {
-        out.clear();
-        return true;
+        setError(std::string("Cannot create body file: ") + std::strerror(errno));
+        return false;
     }
-    std::vector<char> buf(length);
-    iss.read(&buf[0], static_cast<std::streamsize>(length));
-    std::streamsize got = iss.gcount();
-    if (static_cast<size_t>(got) != length)
+    unlink(path);
+    DEBUG_PRINT("Body over " << _bufferSize << " bytes, spooling to a temporary file");
+    if (!writeFile(_body.data(), _body.size()))
         return false;
-    out.assign(&buf[0], &buf[0] + length);
+    std::string().swap(_body);
     return true;
 }
 
-bool HTTPBody::readCRLF(std::istringstream& iss)
+bool HTTPBody::writeFile(const char *data, size_t len)
 {
-    // Consume CRLF exactly. Some clients may send LF only, but HTTP/1.1
-    // requires CRLF; we enforce CRLF here for stricter compliance.
-    char cr = 0, lf = 0;
-    if (!iss.get(cr)) return false;
-    if (!iss.get(lf)) return false;
-    return (cr == '\r' && lf == '\n');
+    while (len > 0)
+    {
+        ssize_t n = write(_fd, data, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            setError(std::string("Cannot write body file: ") + std::strerror(errno));
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
 }
 
-bool HTTPBody::parseChunkSizeLine(std::istringstream& iss, size_t& outSize)
+void HTTPBody::setError(const std::string& message)
 {
-    // Read a single "chunk-size[;chunk-extension]" line and parse the size
-    // (hexadecimal). Extensions are ignored for now.
-    std::string line;
-    if (!std::getline(iss, line))
-    {
-        setError("Unexpected end of input while reading chunk size");
-        return false;
-    }
-    trimTrailingCR(line);
+    _errorMessage = message;
+    DEBUG_PRINT("HTTPBody error: " << message);
+}
+
+bool HTTPBody::parseChunkSize(const std::string& sizeLine, size_t& outSize)
+{
+    // Parse a single "chunk-size[;chunk-extension]" line (hexadecimal).
+    // Extensions are ignored for now.
+    std::string line = sizeLine;
 
     // Remove chunk extensions if present
     std::string::size_type scPos = line.find(';');
     if (scPos != std::string::npos)
-        line = line.substr(0, scPos);
+        line.erase(scPos);
 
     // Trim whitespace
     line = HTTPValidation::trim(line);
@@ -99,135 +128,25 @@ bool HTTPBody::parseChunkSizeLine(std::istringstream& iss, size_t& outSize)
         setError("Empty chunk size line");
         return false;
     }
+    if (line.size() > CHUNK_SIZE_MAX_DIGITS)
+    {
+        setError("Chunk size too large");
+        return false;
+    }
 
     // Validate hex digits and parse
+    size_t parsed = 0;
     for (size_t i = 0; i < line.size(); ++i)
     {
-        if (!std::isxdigit(static_cast<unsigned char>(line[i])))
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        if (!std::isxdigit(c))
         {
             setError("Invalid chunk size: non-hex character found");
             return false;
         }
+        parsed = parsed * 16 + (std::isdigit(c) ? c - '0' : std::tolower(c) - 'a' + 10);
     }
-
-    unsigned long parsed = 0;
-    std::istringstream hexss(line);
-    hexss >> std::hex >> parsed;
-    if (hexss.fail())
-    {
-        setError("Failed to parse chunk size");
-        return false;
-    }
-    outSize = static_cast<size_t>(parsed);
+    outSize = parsed;
     DEBUG_PRINT("Chunk size: " << outSize);
     return true;
 }
-
-bool HTTPBody::parseChunkedBody(std::istringstream& iss)
-{
-    // Implements RFC 7230 chunked coding:
-    //  chunk = chunk-size [; chunk-ext] CRLF
-    //          chunk-data CRLF
-    //  last-chunk = 1*('0') [; chunk-ext] CRLF
-    //               trailer-section CRLF
-    _body.clear();
-    while (true)
-    {
-        size_t chunkSize = 0;
-        if (!parseChunkSizeLine(iss, chunkSize))
-            return false;
-
-        if (chunkSize == 0)
-        {
-            // End of chunks: consume CRLF that terminates the zero-length chunk
-            if (!readCRLF(iss))
-            {
-                setError("Missing CRLF after zero-size chunk");
-                return false;
-            }
-            // Read optional trailer headers until an empty line
-            std::string trailer;
-            while (std::getline(iss, trailer))
-            {
-                trimTrailingCR(trailer);
-                if (trailer.empty())
-                    break; // End of trailers
-                // Optionally, handle trailer headers here
-            }
-            DEBUG_PRINT("Finished parsing chunked body, total size: " << _body.size());
-            return true;
-        }
-
-        // Read exactly 'chunkSize' bytes of data for this chunk.
-        std::string chunk;
-        if (!readExact(iss, chunkSize, chunk))
-        {
-            setError("Chunk data shorter than declared size");
-            return false;
-        }
-        _body.append(chunk);
-
-        // Each chunk is followed by CRLF
-        if (!readCRLF(iss))
-        {
-            setError("Missing CRLF after chunk data");
-            return false;
-        }
-    }
-}
-
-bool HTTPBody::parseFixedLengthBody(std::istringstream& iss, size_t length)
-{
-    // Content-Length driven parsing: read exactly N bytes and store.
-    _body.clear();
-    std::string data;
-    if (!readExact(iss, length, data))
-    {
-        setError("Body shorter than Content-Length");
-        return false;
-    }
-    _body = data;
-    return true;
-}
-
-bool HTTPBody::parse(std::istringstream& iss, const HTTPHeaders& headers, const std::string& method)
-{
-    // Decide body parsing strategy using the already-parsed headers.
-    // Method is informational for future enhancements (e.g., validating
-    // that certain methods typically do not include a body).
-    //
-    // Notes:
-    // - If both Content-Length and Transfer-Encoding are present, HTTP/1.1
-    //   dictates that Transfer-Encoding takes precedence. We follow that by
-    //   checking isChunked() first.
-    // - We do not parse multipart or form-encoded data here; only framing.
-    (void)method; // Currently unused; kept for future logic and debug
-    _isValid = false;
-    _errorMessage.clear();
-
-    if (headers.isChunked())
-    {
-        DEBUG_PRINT("HTTPBody: parsing Transfer-Encoding: chunked");
-        if (!parseChunkedBody(iss))
-            return false;
-        _isValid = true;
-        return true;
-    }
-    if (headers.hasContentLength())
-    {
-        size_t len = headers.getContentLength();
-        DEBUG_PRINT("HTTPBody: parsing Content-Length: " << len);
-        if (!parseFixedLengthBody(iss, len))
-            return false;
-        _isValid = true;
-        return true;
-    }
-
-    // No length provided: read remaining bytes as-is
-    DEBUG_PRINT("HTTPBody: no explicit length; reading remaining stream");
-    std::ostringstream bodyStream;
-    bodyStream << iss.rdbuf();
-    _body = bodyStream.str();
-    _isValid = true;
-    return true;
-}
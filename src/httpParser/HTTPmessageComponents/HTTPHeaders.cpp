@@ -13,7 +13,6 @@
 #include "HTTPHeaders.hpp"
 #include "HTTPValidation.hpp"
 #include "Common.hpp"
-#include <algorithm>
 
 HTTPHeaders::HTTPHeaders()
     : _contentLength(0), _hasContentLength(false), _isChunked(false), _isValid(false)
@@ -25,111 +24,78 @@ HTTPHeaders::~HTTPHeaders()
 {
 }
 
-// Parse headers from input stream until empty line is found
-// Reads header lines from the input stream, validates them, and stores
-// them in the internal map. Stops when an empty line is encountered.
-// iss: Input string stream containing header lines
-// return true if parsing was successful, false otherwise
-bool HTTPHeaders::parseHeaders(std::istringstream &iss)
+// Called once the empty line that ends the header section was received:
+// validate the parsed headers for conflicts and basic consistency.
+// Example: both Content-Length and Transfer-Encoding present ->
+// Transfer-Encoding takes precedence.
+// return true if the header section is valid, false otherwise
+bool HTTPHeaders::finishHeaders()
 {
-    // Reset any previous state. We'll accumulate headers in _headers map.
-    reset();
-    std::string line;
-
-    DEBUG_PRINT("Starting header parsing");
-
-    // Parse each header line until empty line
-    while (std::getline(iss, line))
-    {
-        // Remove trailing CR if present
-        trimTrailingCR(line);
-
-        // Empty line indicates end of headers
-        if (isEmptyLine(line))
-        {
-            DEBUG_PRINT("Found empty line, headers complete");
-            break;
-        }
-
-        // Parse this header line
-        if (!parseHeaderLine(line))
-        {
-            DEBUG_PRINT("Failed to parse header line: " << line);
-            return false;
-        }
-    }
-
-    // Validate the parsed headers for conflicts and basic consistency.
-    // Example: both Content-Length and Transfer-Encoding present ->
-    // Transfer-Encoding takes precedence.
     if (!validateHeaders())
         return false;
 
     _isValid = true;
-    DEBUG_PRINT("Successfully parsed " << _headers.size() << " headers");
+    DEBUG_PRINT("Successfully parsed " << _fields.size() << " headers");
 
     return true;
 }
 
-// Parse a single header line
-// Parses a line in the format "name: value" and adds it to the headers map.
-// Validates both name and value according to HTTP specifications.
-// line: The header line to parse
+// Parses a line in the format "name: value" held in raw() at offset/len,
+// with the colon already located by the scanner, and records it as a
+// slice. Validates both name and value according to HTTP specifications.
 // return true if parsing was successful, false otherwise
-bool HTTPHeaders::parseHeaderLine(const std::string &line)
+bool HTTPHeaders::parseHeaderLine(size_t offset, size_t len, size_t colon)
 {
-    // Find the colon separator
-    std::string::size_type colonPos = line.find(':');
-    if (colonPos == std::string::npos)
+    if (colon == std::string::npos || colon >= offset + len)
     {
-        setError("Invalid header format, missing colon: " + line);
+        setError("Invalid header format, missing colon: " + _raw.substr(offset, len));
         return false;
     }
 
-    // Extract and trim name and value
-    // The value portion may have leading spaces which we trim.
-    std::string name = HTTPValidation::trim(line.substr(0, colonPos));
-    std::string value = HTTPValidation::trim(line.substr(colonPos + 1));
+    // Extract and trim name and value (the value portion may have leading
+    // spaces); only the slice bounds move, nothing is copied
+    Field field;
+    field.name = offset;
+    field.nameLen = colon - offset;
+    while (field.nameLen > 0 && std::isspace(static_cast<unsigned char>(_raw[offset + field.nameLen - 1])))
+        --field.nameLen;
+    while (field.nameLen > 0 && std::isspace(static_cast<unsigned char>(_raw[field.name])))
+    {
+        ++field.name;
+        --field.nameLen;
+    }
+    field.value = colon + 1;
+    field.valueLen = offset + len - field.value;
+    while (field.valueLen > 0 && std::isspace(static_cast<unsigned char>(_raw[field.value])))
+    {
+        ++field.value;
+        --field.valueLen;
+    }
+    while (field.valueLen > 0 && std::isspace(static_cast<unsigned char>(_raw[field.value + field.valueLen - 1])))
+        --field.valueLen;
 
     // Validate header name
-    if (!HTTPValidation::isValidHeaderName(name))
+    if (!HTTPValidation::isValidHeaderName(_raw.data() + field.name, field.nameLen))
     {
-        setError("Invalid header name: " + name);
+        setError("Invalid header name: " + _raw.substr(field.name, field.nameLen));
         return false;
     }
 
     // Validate header value
-    if (!HTTPValidation::isValidHeaderValue(value))
+    if (!HTTPValidation::isValidHeaderValue(_raw.data() + field.value, field.valueLen))
     {
-        setError("Invalid header value for " + name + ": " + value);
+        setError("Invalid header value for " + _raw.substr(field.name, field.nameLen));
         return false;
     }
 
-    // Add the header
-    return addHeader(name, value);
-}
-
-// Add a header to the collection
-// name: Header name
-// value: Header value
-// return true if header was added successfully, false otherwise
-bool HTTPHeaders::addHeader(const std::string &name, const std::string &value)
-{
-    if (name.empty())
-        return false;
-
-    std::string lowerName = toLowercase(name);
-
-    // Store original case for potential future use
-    _originalKeys[lowerName] = name;
-
-    // Store the header with lowercase key for case-insensitive lookup
-    _headers[lowerName] = value;
+    field.id = HTTPKnownHeaders::lookup(_raw.data() + field.name, field.nameLen);
+    _fields.push_back(field);
 
     // Process special headers that need additional parsing
-    processSpecialHeaders(lowerName, value);
+    if (!processSpecialHeaders(_fields.size() - 1))
+        return false;
 
-    DEBUG_PRINT("Added header: [" << name << "] = [" << value << "]");
+    DEBUG_PRINT("Added header: [" << getName(_fields.size() - 1) << "] = [" << getValue(_fields.size() - 1) << "]");
 
     return true;
 }
@@ -137,92 +103,167 @@ bool HTTPHeaders::addHeader(const std::string &name, const std::string &value)
 /**
  * @brief Process special headers that require additional handling
  *
- * @param lowerName Header name in lowercase
- * @param value Header value
+ * The framing headers are strict: a message whose body length could be
+ * read two ways (by us and by a proxy in front of us) is rejected.
+ *
+ * @param index Index of the header in _fields
+ * @return false if the header makes the message invalid
  */
-void HTTPHeaders::processSpecialHeaders(const std::string &lowerName, const std::string &value)
+bool HTTPHeaders::processSpecialHeaders(size_t index)
 {
-    if (lowerName == "content-length")
-    {
-        _hasContentLength = parseContentLength(value);
-    }
-    else if (lowerName == "transfer-encoding")
-    {
-        _transferEncoding = value;
-        parseTransferEncoding(value);
-    }
-    else if (lowerName == "content-type")
-    {
-        _contentType = value;
-    }
-    else if (lowerName == "host")
-    {
-        _host = value;
-        parseHostHeader(value);
-    }
-    else if (lowerName == "connection")
+    const Field &field = _fields[index];
+    if (field.id == HEADER_UNKNOWN)
+        return true;
+
+    // The last occurrence wins, as for lookups by name
+    _known[field.id] = static_cast<int>(index);
+
+    switch (field.id)
     {
-        _connection = value;
+    case HEADER_CONTENT_LENGTH:
+        return parseContentLength(field);
+    case HEADER_TRANSFER_ENCODING:
+        return parseTransferEncoding(field);
+    default:
+        return true;
     }
 }
 
 /**
- * @brief Parse Host header for CGI SERVER_NAME and SERVER_PORT
+ * @brief Host name part of the Host header (for CGI SERVER_NAME)
+ */
+std::string HTTPHeaders::getHostName() const
+{
+    int host = _known[HEADER_HOST];
+    if (host < 0)
+        return "";
+    const Field &field = _fields[host];
+    const char *colon = static_cast<const char *>(std::memchr(_raw.data() + field.value, ':', field.valueLen));
+    size_t len = colon ? static_cast<size_t>(colon - (_raw.data() + field.value)) : field.valueLen;
+    return _raw.substr(field.value, len);
+}
+
+/**
+ * @brief Port part of the Host header (for CGI SERVER_PORT), "80" if none
+ */
+std::string HTTPHeaders::getHostPort() const
+{
+    int host = _known[HEADER_HOST];
+    if (host < 0)
+        return "";
+    const Field &field = _fields[host];
+    const char *colon = static_cast<const char *>(std::memchr(_raw.data() + field.value, ':', field.valueLen));
+    if (colon == NULL)
+        return "80"; // Default HTTP port
+    size_t offset = (colon - _raw.data()) + 1;
+    return _raw.substr(offset, field.value + field.valueLen - offset);
+}
+
+/**
+ * @brief Parse Content-Length header value
+ *
+ * A repeated Content-Length is accepted only with the same value.
  *
- * @param hostValue The Host header value
+ * @param field The Content-Length header
+ * @return true if parsing was successful, false otherwise
  */
-void HTTPHeaders::parseHostHeader(const std::string &hostValue)
+bool HTTPHeaders::parseContentLength(const Field &field)
 {
-    // Split host and port if port is specified
-    std::string::size_type colonPos = hostValue.find(':');
-    if (colonPos != std::string::npos)
+    size_t length;
+    std::string value = _raw.substr(field.value, field.valueLen);
+    if (!HTTPValidation::isValidContentLength(value, length))
     {
-        _hostName = hostValue.substr(0, colonPos);
-        _hostPort = hostValue.substr(colonPos + 1);
+        setError("Invalid Content-Length value: " + value);
+        return false;
     }
-    else
+    if (_hasContentLength && length != _contentLength)
     {
-        _hostName = hostValue;
-        _hostPort = "80"; // Default HTTP port
+        setError("Conflicting Content-Length values");
+        return false;
     }
+    _contentLength = length;
+    _hasContentLength = true;
+    return true;
 }
 
 /**
- * @brief Parse Content-Length header value
+ * @brief Parse Transfer-Encoding header value
  *
- * @param value The Content-Length value to parse
+ * The codings form one list over all Transfer-Encoding headers, and the
+ * only body framing we can read is chunked as the final coding: anything
+ * else (no chunked, "chunked, gzip", chunked twice) is an error.
+ *
+ * @param field The Transfer-Encoding header
  * @return true if parsing was successful, false otherwise
  */
-bool HTTPHeaders::parseContentLength(const std::string &value)
+bool HTTPHeaders::parseTransferEncoding(const Field &field)
 {
-    size_t length;
-    if (HTTPValidation::isValidContentLength(value, length))
+    const char *p = _raw.data() + field.value;
+    const char *end = p + field.valueLen;
+    bool any = false;
+    while (p < end)
     {
-        _contentLength = length;
-        return true;
+        const char *comma = static_cast<const char *>(std::memchr(p, ',', end - p));
+        const char *next = comma ? comma : end;
+        const char *last = next;
+        while (p < last && (*p == ' ' || *p == '\t'))
+            ++p;
+        while (last > p && (last[-1] == ' ' || last[-1] == '\t'))
+            --last;
+        if (last > p) // empty list elements are allowed and skipped
+        {
+            // A coding after chunked: the body framing is not chunked
+            if (_isChunked)
+                break;
+            _isChunked = HTTPValidation::equalsIgnoreCase(p, last - p, "chunked");
+            any = true;
+        }
+        p = comma ? comma + 1 : end;
     }
-    else
+    if (!any || p < end || !_isChunked)
     {
-        setError("Invalid Content-Length value: " + value);
+        setError("Unsupported Transfer-Encoding: " + _raw.substr(field.value, field.valueLen));
+        _isChunked = false;
         return false;
     }
+    return true;
 }
 
 /**
- * @brief Parse Transfer-Encoding header value
+ * @brief Index of the last header with this name (case-insensitive)
  *
- * @param value The Transfer-Encoding value to parse
- * @return true if parsing was successful, false otherwise
+ * A known name goes straight to its slot; other names are compared with
+ * the unknown fields only.
+ *
+ * @param name Header name to look for
+ * @return Index in _fields, -1 if not found
  */
-bool HTTPHeaders::parseTransferEncoding(const std::string &value)
+int HTTPHeaders::findField(const std::string &name) const
 {
-    // Convert to lowercase for comparison
-    std::string lowerValue = toLowercase(value);
+    if (!HTTPValidation::isValidHeaderName(name))
+        return -1;
+    HTTPHeaderId id = HTTPKnownHeaders::lookup(name.data(), name.size());
+    if (id != HEADER_UNKNOWN)
+        return _known[id];
 
-    // Check if chunked encoding is specified
-    _isChunked = (lowerValue.find("chunked") != std::string::npos);
+    for (size_t i = _fields.size(); i > 0; --i)
+    {
+        const Field &field = _fields[i - 1];
+        if (field.id == HEADER_UNKNOWN &&
+            HTTPValidation::equalsIgnoreCase(_raw.data() + field.name, field.nameLen, name.c_str()))
+            return static_cast<int>(i - 1);
+    }
+    return -1;
+}
 
-    return true;
+/**
+ * @brief Copy of the value of a header, empty if index is -1
+ */
+std::string HTTPHeaders::fieldValue(int index) const
+{
+    if (index < 0)
+        return "";
+    return _raw.substr(_fields[index].value, _fields[index].valueLen);
 }
 
 /**
@@ -233,8 +274,7 @@ bool HTTPHeaders::parseTransferEncoding(const std::string &value)
  */
 bool HTTPHeaders::hasHeader(const std::string &name) const
 {
-    std::string lowerName = toLowercase(name);
-    return _headers.find(lowerName) != _headers.end();
+    return findField(name) >= 0;
 }
 
 /**
@@ -245,23 +285,32 @@ bool HTTPHeaders::hasHeader(const std::string &name) const
  */
 std::string HTTPHeaders::getHeader(const std::string &name) const
 {
-    std::string lowerName = toLowercase(name);
-    std::map<std::string, std::string>::const_iterator it = _headers.find(lowerName);
-    if (it != _headers.end())
-        return it->second;
-    return "";
+    return fieldValue(findField(name));
 }
 
 /**
- * @brief Remove a header (case-insensitive)
+ * @brief Get a header value without copying it
  *
- * @param name Header name to remove
+ * @param name Header name to get (case-insensitive)
+ * @param len Set to the length of the value
+ * @return Start of the value inside raw(), NULL if not found
  */
-void HTTPHeaders::removeHeader(const std::string &name)
+const char *HTTPHeaders::findHeader(const std::string &name, size_t &len) const
+{
+    int index = findField(name);
+    if (index < 0)
+        return NULL;
+    len = _fields[index].valueLen;
+    return _raw.data() + _fields[index].value;
+}
+
+const char *HTTPHeaders::findHeader(HTTPHeaderId id, size_t &len) const
 {
-    std::string lowerName = toLowercase(name);
-    _headers.erase(lowerName);
-    _originalKeys.erase(lowerName);
+    int index = findField(id);
+    if (index < 0)
+        return NULL;
+    len = _fields[index].valueLen;
+    return _raw.data() + _fields[index].value;
 }
 
 /**
@@ -289,15 +338,13 @@ bool HTTPHeaders::validateHeaders() const
  */
 void HTTPHeaders::reset()
 {
-    _headers.clear();
-    _originalKeys.clear();
+    _raw.clear();
+    _fields.clear();
     _contentLength = 0;
     _hasContentLength = false;
     _isChunked = false;
-    _contentType.clear();
-    _host.clear();
-    _connection.clear();
-    _transferEncoding.clear();
+    for (size_t i = 0; i < HEADER_COUNT; ++i)
+        _known[i] = -1;
     _isValid = false;
     _errorMessage.clear();
 }
@@ -312,39 +359,4 @@ void HTTPHeaders::setError(const std::string &message)
     _isValid = false;
     _errorMessage = message;
     DEBUG_PRINT("Header parsing error: " << message);
-}
-
-/**
- * @brief Convert string to lowercase
- *
- * @param str String to convert
- * @return Lowercase version of the string
- */
-std::string HTTPHeaders::toLowercase(const std::string &str) const
-{
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-    return result;
-}
-
-/**
- * @brief Remove trailing carriage return if present
- *
- * @param line String to trim
- */
-void HTTPHeaders::trimTrailingCR(std::string &line)
-{
-    if (!line.empty() && line[line.size() - 1] == '\r')
-        line.erase(line.size() - 1);
-}
-
-/**
- * @brief Check if line is empty (considering just spaces and CR)
- *
- * @param line Line to check
- * @return true if line is effectively empty, false otherwise
- */
-bool HTTPHeaders::isEmptyLine(const std::string &line) const
-{
-    return line.empty() || line == "\r";
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "HTTPKnownHeaders.hpp"
+
+// Indexed by HTTPHeaderId
+const HTTPKnownHeaders::Entry HTTPKnownHeaders::_entries[HEADER_COUNT] = {
+    {"Accept", 6, "HTTP_ACCEPT"},
+    {"Accept-Charset", 14, "HTTP_ACCEPT_CHARSET"},
+    {"Accept-Encoding", 15, "HTTP_ACCEPT_ENCODING"},
+    {"Accept-Language", 15, "HTTP_ACCEPT_LANGUAGE"},
+    {"Authorization", 13, "HTTP_AUTHORIZATION"},
+    {"Cache-Control", 13, "HTTP_CACHE_CONTROL"},
+    {"Connection", 10, "HTTP_CONNECTION"},
+    {"Content-Length", 14, "HTTP_CONTENT_LENGTH"},
+    {"Content-Type", 12, "HTTP_CONTENT_TYPE"},
+    {"Cookie", 6, "HTTP_COOKIE"},
+    {"Expect", 6, "HTTP_EXPECT"},
+    {"Host", 4, "HTTP_HOST"},
+    {"If-Modified-Since", 17, "HTTP_IF_MODIFIED_SINCE"},
+    {"If-None-Match", 13, "HTTP_IF_NONE_MATCH"},
+    {"If-Range", 8, "HTTP_IF_RANGE"},
+    {"If-Unmodified-Since", 19, "HTTP_IF_UNMODIFIED_SINCE"},
+    {"Origin", 6, "HTTP_ORIGIN"},
+    {"Range", 5, "HTTP_RANGE"},
+    {"Referer", 7, "HTTP_REFERER"},
+    {"Transfer-Encoding", 17, NULL}, // framing, the script gets the decoded body
+    {"Upgrade", 7, "HTTP_UPGRADE"},
+    {"User-Agent", 10, "HTTP_USER_AGENT"},
+    {"X-Forwarded-For", 15, "HTTP_X_FORWARDED_FOR"},
+};
+
+#define U HEADER_UNKNOWN
+
+/* Slot of every name under slotOf(). The multipliers were searched so that
+   no two names share a slot; a new name needs a free slot (or a new search
+   if it collides), otherwise lookup() stops finding one of them. */
+const unsigned char HTTPKnownHeaders::_slots[64] = {
+    U, HEADER_UPGRADE, U, U, U, U, U, HEADER_CONNECTION,
+    U, U, U, U, HEADER_AUTHORIZATION, HEADER_USER_AGENT, U, U,
+    HEADER_TRANSFER_ENCODING, U, U, U, U, HEADER_COOKIE, U, U,
+    U, HEADER_IF_RANGE, U, HEADER_ACCEPT_LANGUAGE, U, HEADER_X_FORWARDED_FOR, U, HEADER_ORIGIN,
+    HEADER_ACCEPT_ENCODING, U, U, U, HEADER_CONTENT_TYPE, HEADER_ACCEPT, U, U,
+    U, HEADER_IF_UNMODIFIED_SINCE, HEADER_IF_MODIFIED_SINCE, HEADER_ACCEPT_CHARSET, U, HEADER_EXPECT, U, U,
+    U, HEADER_CONTENT_LENGTH, U, U, HEADER_IF_NONE_MATCH, HEADER_RANGE, U, U,
+    U, U, U, U, HEADER_REFERER, U, HEADER_CACHE_CONTROL, HEADER_HOST,
+};
+
+#undef U
+
+// Length plus the first, middle and last byte, lowercased (| 0x20 is
+// enough: names are letters, digits and '-')
+static inline unsigned int slotOf(const char *name, size_t len)
+{
+    unsigned int first = static_cast<unsigned char>(name[0]) | 0x20;
+    unsigned int middle = static_cast<unsigned char>(name[len / 2]) | 0x20;
+    unsigned int last = static_cast<unsigned char>(name[len - 1]) | 0x20;
+    return (len + first * 2 + last * 6 + middle) & 63;
+}
+
+HTTPHeaderId HTTPKnownHeaders::lookup(const char *name, size_t len)
+{
+    if (len == 0)
+        return HEADER_UNKNOWN;
+    unsigned char id = _slots[slotOf(name, len)];
+    if (id == HEADER_UNKNOWN || _entries[id].len != len)
+        return HEADER_UNKNOWN;
+    // Same slot and length: one compare decides
+    const char *known = _entries[id].name;
+    for (size_t i = 0; i < len; ++i)
+    {
+        if ((static_cast<unsigned char>(name[i]) | 0x20) != (static_cast<unsigned char>(known[i]) | 0x20))
+            return HEADER_UNKNOWN;
+    }
+    return static_cast<HTTPHeaderId>(id);
+}
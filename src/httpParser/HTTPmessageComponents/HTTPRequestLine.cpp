@@ -13,6 +13,15 @@
 #include "HTTPHeaders.hpp"
 #include "HTTPValidation.hpp"
 #include "Common.hpp"
+#include <cstring>
+
+// Indexed by HTTPMethod; method names are case-sensitive
+const std::string HTTPRequestLine::_methodNames[METHOD_OTHER] = {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+
+// Indexed by HTTPVersion
+const std::string HTTPRequestLine::_versionNames[HTTP_VERSION_UNKNOWN + 1] = {
+    "HTTP/1.0", "HTTP/1.1", ""};
 
 HTTPRequestLine::HTTPRequestLine()
     : _isValid(false)
@@ -24,147 +33,140 @@ HTTPRequestLine::~HTTPRequestLine()
 {
 }
 
+// isspace() in the C locale, without the locale lookup per byte
+static inline bool isSeparator(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Bounds of the next whitespace-separated word from pos; returns false if
+// the rest of the line is blank
+static bool nextWord(const char *line, size_t len, size_t &pos, size_t &start, size_t &wordLen)
+{
+    while (pos < len && isSeparator(line[pos]))
+        ++pos;
+    if (pos == len)
+        return false;
+    start = pos;
+    while (pos < len && !isSeparator(line[pos]))
+        ++pos;
+    wordLen = pos - start;
+    return true;
+}
+
 /*
 Parse the HTTP request line
  
- Parses a request line string into method, path, and version components.
- Validates each component according to HTTP specifications.
+ Splits the line into method, path, and version in one pass and
+ validates each component according to HTTP specifications.
  
- requestLine The raw request line string
+ line/len  The request line without its CRLF
  return true if parsing was successful, false otherwise
  */
-bool HTTPRequestLine::parseRequestLine(const std::string& requestLine)
+bool HTTPRequestLine::parseRequestLine(const char *line, size_t len)
 {
-    // Reset previous state and keep the original request line for diagnostics
     reset();
-    _rawLine = requestLine;
-    
-    DEBUG_PRINT("Parsing request line: " << requestLine);
-    
-    // Check if the line is empty
-    if (requestLine.empty())
+    if (len == 0)
     {
         setError("Request line is empty");
         return false;
     }
-    
-    // Create a copy for processing
-    std::string line = requestLine;
-    trimTrailingCR(line);
-    
-    // Parse components using stringstream: tokens are whitespace-separated.
-    // Expect exactly three tokens: METHOD SP PATH SP VERSION.
-    std::istringstream iss(line);
-    if (!parseComponents(iss))
-        return false;
+    if (line[len - 1] == '\r')
+        --len;
 
-    if (!validatePath(_path))
+    // Expect exactly three words: METHOD SP PATH SP VERSION
+    size_t pos = 0;
+    size_t method = 0;
+    size_t methodLen = 0;
+    size_t version = 0;
+    size_t versionLen = 0;
+    size_t extra = 0;
+    size_t extraLen = 0;
+    if (!nextWord(line, len, pos, method, methodLen))
     {
-        setError("Invalid request path: " + _path);
+        setError("Missing HTTP method");
         return false;
     }
-
-    // Validate each component
-    if (!validateMethod(_method))
+    if (!nextWord(line, len, pos, _target, _targetLen))
     {
-        setError("Invalid HTTP method: " + _method);
+        setError("Missing request path");
         return false;
     }
-    
-    if (!validateVersion(_version))
+    if (!nextWord(line, len, pos, version, versionLen)) // Ex: HTTP/1.1
     {
-        setError("Invalid HTTP version: " + _version);
+        setError("Missing HTTP version");
         return false;
     }
-    
-    _isValid = true;
-    DEBUG_PRINT("Successfully parsed request line - Method: " << _method 
-                << ", Path: " << _path << ", Version: " << _version);
-    
-    return true;
-}
-
-/*
-Parse the three components from the request line
-
-iss Input string stream containing the request line
-return true if all three components were extracted, false otherwise
-*/
-bool HTTPRequestLine::parseComponents(std::istringstream& iss)
-{
-    // Extract method, path, and version separated by spaces
-    if (!(iss >> _method))
+    if (nextWord(line, len, pos, extra, extraLen))
     {
-        setError("Missing HTTP method");
+        setError("Too many components in request line");
         return false;
     }
-    
-    if (!(iss >> _path))
+
+    // Validate each component
+    if (!HTTPValidation::isValidTarget(line + _target, _targetLen))
     {
-        setError("Missing request path");
+        setError("Invalid request path: " + std::string(line + _target, _targetLen));
         return false;
     }
-    
-    if (!(iss >> _version)) // Ex: HTTP/1.1
+    // Per RFCs, the method is a token: unknown methods are valid syntax
+    if (!HTTPValidation::isValidMethod(line + method, methodLen))
     {
-        setError("Missing HTTP version");
+        setError("Invalid HTTP method: " + std::string(line + method, methodLen));
         return false;
     }
-    
-    // Check if there are extra components (which would be invalid)
-    std::string extra; // Any extra token means malformed request line
-    if (iss >> extra)
+    _method = lookupMethod(line + method, methodLen);
+    if (_method == METHOD_OTHER)
+        _otherMethod.assign(line + method, methodLen);
+
+    for (int v = HTTP_1_0; v < HTTP_VERSION_UNKNOWN; ++v)
     {
-        setError("Too many components in request line");
+        const std::string &name = _versionNames[v];
+        if (versionLen == name.size() && std::memcmp(line + version, name.data(), versionLen) == 0)
+            _version = static_cast<HTTPVersion>(v);
+    }
+    if (_version == HTTP_VERSION_UNKNOWN)
+    {
+        setError("Invalid HTTP version: " + std::string(line + version, versionLen));
         return false;
     }
     
+    _isValid = true;
+    DEBUG_PRINT("Successfully parsed request line - Method: " << getMethod()
+                << ", Path: " << std::string(line + _target, _targetLen) << ", Version: " << getVersion());
+    
     return true;
 }
 
-// Validate HTTP method
-// The method string to validate
-//return true if the method is valid, false otherwise
-bool HTTPRequestLine::validateMethod(const std::string& method)
+bool HTTPRequestLine::parseRequestLine(const std::string& requestLine)
 {
-    if (method.empty())
-        return false;
-    
-    return HTTPValidation::isValidMethod(method);
+    return parseRequestLine(requestLine.data(), requestLine.size());
 }
 
-// Validate request path with security checks
-// The path string to validate
-// return true if the path is valid and safe, false otherwise
-bool HTTPRequestLine::validatePath(const std::string& path)
+HTTPMethod HTTPRequestLine::lookupMethod(const char *name, size_t len)
 {
-    if (path.empty())
-        return false;
-    
-    // We validate only the path component (request-target) here and do not
-    // implement query-string parsing or percent-decoding. Those can be
-    // layered later if needed by routing.
-    return HTTPValidation::isValidPath(path);
+    for (int m = METHOD_GET; m < METHOD_OTHER; ++m)
+    {
+        const std::string &known = _methodNames[m];
+        if (len == known.size() && std::memcmp(name, known.data(), len) == 0)
+            return static_cast<HTTPMethod>(m);
+    }
+    return METHOD_OTHER;
 }
 
-// Validate HTTP version
-// The version string to validate
-// return true if the version is supported, false otherwise
-bool HTTPRequestLine::validateVersion(const std::string& version)
+const std::string& HTTPRequestLine::getMethod() const
 {
-    if (version.empty())
-        return false;
-    
-    return HTTPValidation::isValidVersion(version);
+    return _method == METHOD_OTHER ? _otherMethod : _methodNames[_method];
 }
 
 // Reset the object to initial state
 void HTTPRequestLine::reset()
 {
-    _method.clear();
-    _path.clear();
-    _version.clear();
-    _rawLine.clear();
+    _method = METHOD_OTHER;
+    _otherMethod.clear();
+    _version = HTTP_VERSION_UNKNOWN;
+    _target = 0;
+    _targetLen = 0;
     _isValid = false;
     _errorMessage.clear();
 }
@@ -177,11 +179,3 @@ void HTTPRequestLine::setError(const std::string& message)
     _errorMessage = message;
     DEBUG_PRINT("Request line error: " << message);
 }
-
-// Remove trailing carriage return character if present
-// String to trim
-void HTTPRequestLine::trimTrailingCR(std::string& line)
-{
-    if (!line.empty() && line[line.size() - 1] == '\r')
-        line.erase(line.size() - 1);
-}
\ No newline at end of file
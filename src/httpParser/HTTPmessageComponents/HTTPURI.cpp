@@ -0,0 +1,141 @@
+#include "HTTPURI.hpp"
+#include "Common.hpp"
+#include <cstring>
+
+HTTPURI::HTTPURI() : _hasQuery(false)
+{
+}
+
+HTTPURI::~HTTPURI()
+{
+}
+
+// Keeps the capacity of the strings for the next request
+void HTTPURI::reset()
+{
+    _target.clear();
+    _path.clear();
+    _query.clear();
+    _hasQuery = false;
+    _segments.clear();
+    _errorMessage.clear();
+}
+
+bool HTTPURI::setError(const std::string &message)
+{
+    _errorMessage = message;
+    DEBUG_PRINT("URI error: " << message);
+    return false;
+}
+
+bool HTTPURI::parse(const char *target, size_t len)
+{
+    reset();
+    _target.assign(target, len);
+    if (len == 0 || target[0] != '/')
+        return setError("Request target is not an absolute path");
+
+    // A fragment is never sent by a conforming client; drop it if it is
+    const char *hash = static_cast<const char *>(std::memchr(target, '#', len));
+    if (hash != NULL)
+        len = hash - target;
+    const char *question = static_cast<const char *>(std::memchr(target, '?', len));
+    size_t pathLen = len;
+    if (question != NULL)
+    {
+        pathLen = question - target;
+        _query.assign(question + 1, len - pathLen - 1);
+        _hasQuery = true;
+    }
+    if (!decodePath(target, pathLen) || !normalizePath())
+        return false;
+    DEBUG_PRINT("URI path: " << _path << (_hasQuery ? ", query: " + _query : ""));
+    return true;
+}
+
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Percent-decode the path into _path
+bool HTTPURI::decodePath(const char *path, size_t len)
+{
+    _path.reserve(len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        char c = path[i];
+        if (c == '%')
+        {
+            int high = i + 2 < len ? hexValue(path[i + 1]) : -1;
+            int low = i + 2 < len ? hexValue(path[i + 2]) : -1;
+            if (high < 0 || low < 0)
+                return setError("Malformed percent-encoding in request path");
+            c = static_cast<char>(high * 16 + low);
+            i += 2;
+        }
+        unsigned char u = static_cast<unsigned char>(c);
+        if (u < 0x20 || u == 0x7f)
+            return setError("Control character in request path");
+        _path += c;
+    }
+    return true;
+}
+
+/*
+  Resolve "." and ".." and merge repeated slashes, in place: the output
+  never gets ahead of the input. A path that ends in a directory ("/a/",
+  "/a/." or "/a/b/..") keeps its trailing slash.
+*/
+bool HTTPURI::normalizePath()
+{
+    char *p = &_path[0];
+    size_t n = _path.size();
+    size_t out = 0;
+    bool dirEnd = true; // "/" alone is a directory
+    size_t i = 0;
+    while (i < n)
+    {
+        while (i < n && p[i] == '/')
+            ++i;
+        size_t start = i;
+        while (i < n && p[i] != '/')
+            ++i;
+        size_t len = i - start;
+        if (len == 0)
+        {
+            dirEnd = true; // trailing slash
+            break;
+        }
+        if (len == 1 && p[start] == '.')
+        {
+            dirEnd = true;
+            continue;
+        }
+        if (len == 2 && p[start] == '.' && p[start + 1] == '.')
+        {
+            if (_segments.empty())
+                return setError("Request path leaves the root directory");
+            out = _segments.back().offset - 1; // drop "/segment"
+            _segments.pop_back();
+            dirEnd = true;
+            continue;
+        }
+        p[out++] = '/';
+        std::memmove(p + out, p + start, len);
+        Segment seg = {out, len};
+        _segments.push_back(seg);
+        out += len;
+        dirEnd = false;
+    }
+    _path.resize(out);
+    if (dirEnd)
+        _path += '/';
+    return true;
+}
@@ -12,28 +12,22 @@
 
 #include "HTTPValidation.hpp"
 #include <cctype>
+#include <cstring>
 #include <sstream>
 
 // HTTP Method validation
 bool HTTPValidation::isValidMethod(const std::string& method)
+{
+    return isValidMethod(method.data(), method.length());
+}
+
+bool HTTPValidation::isValidMethod(const char* method, size_t len)
 {
     // Per RFCs, the request method is a "token". Unknown methods are permitted
     // syntactically and should result in 405 Method Not Allowed at the
     // application level if not supported, not a 400 parsing error.
-    if (method.empty())
-        return false;
-
     // Validate characters according to token rules (no CTLs or separators)
-    const std::string separators = "()<>@,;:\\\"/[]?={} \t";
-    for (size_t i = 0; i < method.length(); ++i)
-    {
-        unsigned char c = static_cast<unsigned char>(method[i]);
-        if (c <= 31 || c >= 127) // Control or non-ASCII
-            return false;
-        if (separators.find(c) != std::string::npos)
-            return false;
-    }
-    return true;
+    return isValidHeaderName(method, len);
 }
 
 std::set<std::string> HTTPValidation::getValidMethods()
@@ -50,8 +44,7 @@ std::set<std::string> HTTPValidation::getValidMethods()
 // HTTP Version validation
 bool HTTPValidation::isValidVersion(const std::string& version)
 {
-    std::set<std::string> supportedVersions = getSupportedVersions();
-    return supportedVersions.find(version) != supportedVersions.end();
+    return version == "HTTP/1.0" || version == "HTTP/1.1";
 }
 
 std::set<std::string> HTTPValidation::getSupportedVersions()
@@ -65,16 +58,23 @@ std::set<std::string> HTTPValidation::getSupportedVersions()
 // Path validation with security checks
 bool HTTPValidation::isValidPath(const std::string& path)
 {
-    // Check if path is empty or doesn't start with '/'
-    if (path.empty() || path[0] != '/')
-        return false;
-    
+    return isValidPath(path.data(), path.length());
+}
+
+bool HTTPValidation::isValidPath(const char* path, size_t len)
+{
     // Check for directory traversal attempts
-    if (containsDirectoryTraversal(path))
+    return isValidTarget(path, len) && !containsDirectoryTraversal(path, len);
+}
+
+bool HTTPValidation::isValidTarget(const char* path, size_t len)
+{
+    // Check if path is empty or doesn't start with '/'
+    if (len == 0 || path[0] != '/')
         return false;
     
     // Check for invalid characters (basic validation)
-    for (size_t i = 0; i < path.length(); ++i)
+    for (size_t i = 0; i < len; ++i)
     {
         char c = path[i];
         // Allow only printable ASCII characters and some special chars commonly used in URLs
@@ -91,14 +91,25 @@ bool HTTPValidation::isValidPath(const std::string& path)
 
 bool HTTPValidation::containsDirectoryTraversal(const std::string& path)
 {
-    // Check for various directory traversal patterns
-    return (path.find("../") != std::string::npos ||
-            path.find("..\\") != std::string::npos ||
-            path.find("/..") != std::string::npos ||
-            path.find("\\..") != std::string::npos ||
-            path == ".." ||
-            path.find("/../") != std::string::npos ||
-            path.find("\\..\\") != std::string::npos);
+    return containsDirectoryTraversal(path.data(), path.length());
+}
+
+bool HTTPValidation::containsDirectoryTraversal(const char* path, size_t len)
+{
+    // ".." next to a slash or backslash ("../", "/..", "..\\", "\\.."), or
+    // the whole path
+    for (size_t i = 0; i + 1 < len; ++i)
+    {
+        if (path[i] != '.' || path[i + 1] != '.')
+            continue;
+        if (len == 2)
+            return true;
+        if (i > 0 && (path[i - 1] == '/' || path[i - 1] == '\\'))
+            return true;
+        if (i + 2 < len && (path[i + 2] == '/' || path[i + 2] == '\\'))
+            return true;
+    }
+    return false;
 }
 
 std::string HTTPValidation::sanitizePath(const std::string& path)
@@ -137,10 +148,7 @@ std::string HTTPValidation::sanitizePath(const std::string& path)
 // Header validation
 bool HTTPValidation::isValidHeaderName(const std::string& name)
 {
-    if (name.empty())
-        return false;
-    
-    return isToken(name);
+    return isValidHeaderName(name.data(), name.length());
 }
 
 bool HTTPValidation::isValidHeaderValue(const std::string& value)
@@ -150,18 +158,47 @@ bool HTTPValidation::isValidHeaderValue(const std::string& value)
 
 bool HTTPValidation::containsInvalidChars(const std::string& value)
 {
-    for (size_t i = 0; i < value.length(); ++i)
+    return !isValidHeaderValue(value.data(), value.length());
+}
+
+bool HTTPValidation::isValidHeaderName(const char* name, size_t len)
+{
+    if (len == 0)
+        return false;
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (!isValidChar(name[i]))
+            return false;
+    }
+    return true;
+}
+
+bool HTTPValidation::isValidHeaderValue(const char* value, size_t len)
+{
+    for (size_t i = 0; i < len; ++i)
     {
         char c = value[i];
         // Check for CR, LF, or NUL characters as per RFC
         if (c == '\r' || c == '\n' || c == '\0')
-            return true;
+            return false;
         
         // Check for other control characters (except TAB which is allowed)
         if (isControlChar(c) && c != '\t')
-            return true;
+            return false;
     }
-    return false;
+    return true;
+}
+
+bool HTTPValidation::equalsIgnoreCase(const char* str, size_t len, const char* other)
+{
+    size_t i = 0;
+    for (; i < len && other[i] != '\0'; ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(str[i])) != std::tolower(static_cast<unsigned char>(other[i])))
+            return false;
+    }
+    return i == len && other[i] == '\0';
 }
 
 // String utility functions
@@ -234,8 +271,7 @@ bool HTTPValidation::isValidChar(char c)
         return false;
     
     // Check for separator characters
-    const std::string separators = "()<>@,;:\\\"/[]?={} \t";
-    return separators.find(c) == std::string::npos;
+    return std::strchr("()<>@,;:\\\"/[]?={} \t", c) == NULL;
 }
 
 bool HTTPValidation::isControlChar(char c)
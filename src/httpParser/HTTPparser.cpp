@@ -12,10 +12,10 @@
 
 // ./src/httpParser/HTTPparser.cpp
 #include "Common.hpp"
-#include "HTTPBody.hpp"
+#include <algorithm>
 
 HTTPparser::HTTPparser()
-    : _state(PARSING_REQUEST_LINE), _isValid(false)
+    : _state(PARSING_REQUEST_LINE), _maxBodySize(0), _isValid(false)
 {
     reset();
 }
@@ -25,204 +25,325 @@ HTTPparser::~HTTPparser()
 }
 
 /*
-Parse the HTTP request line using the HTTPRequestLine module
+    Main method of the parser: consume the next bytes of the request.
 
-iss Input string stream containing the request
-return true if parsing was successful, false otherwise
+    High-level algorithm (HTTP/1.1):
+    1) Request-line: "METHOD SP request-target SP HTTP-version CRLF"
+    2) Header section: 1+ header fields each ending with CRLF
+        - Terminates with an empty line (i.e., the CRLF after the last header
+          is immediately followed by another CRLF)
+    3) Message body (optional): determined by either
+        - Transfer-Encoding: chunked (chunked framing), or
+        - Content-Length: N (fixed-length), or
+        - Absent: a request without either header has no body
+
+    Every byte is looked at once. The header section is collected in the
+    raw buffer of HTTPHeaders until each LF arrives, so a line split over
+    two recv() calls is simply completed by the second one; header fields
+    are recorded as slices of that buffer instead of copied strings. Body
+    bytes are appended to HTTPBody as they come. Parsing stops at the end
+    of the message, getConsumed() tells how many of the bytes passed in
+    belong to it.
+
+    data/len The bytes received since the previous call
+    return the progress made, see FeedResult
 */
-bool HTTPparser::parseRequestLine(std::istringstream &iss)
+HTTPparser::FeedResult HTTPparser::feed(const char *data, size_t len)
 {
-    std::string line;
+    _consumed = 0;
+    if (_state == ERROR)
+        return FEED_ERROR;
+    if (_state == PARSING_COMPLETE)
+        return MESSAGE_COMPLETE;
 
-    // Read the first line up to the first LF. For CRLF-terminated lines,
-    // std::getline leaves the trailing CR; we strip it below in HTTPRequestLine.
-    if (!std::getline(iss, line))
+    bool headersDoneNow = false;
+    if (_state == PARSING_REQUEST_LINE || _state == PARSING_HEADERS)
     {
-        setError("No request line found", "400");
-        return false;
+        _consumed = feedHeaderSection(data, len);
+        headersDoneNow = _headersDone;
     }
+    if (_state != ERROR && _state != PARSING_COMPLETE && _headersDone)
+        _consumed += feedBody(data + _consumed, len - _consumed);
 
-    // Use HTTPRequestLine module to parse the line
-    if (!_requestLine.parseRequestLine(line))
+    if (_state == ERROR)
     {
-        setError("Invalid request line: " + _requestLine.getErrorMessage(), "400");
-        return false;
+        DEBUG_PRINT(MAGENTA << "~~~ HTTP Request Parsing Failed ~~~" << RESET);
+        DEBUG_PRINT("Error: " << _errorMessage);
+        return FEED_ERROR;
     }
-
-    DEBUG_PRINT("Successfully parsed request line - Method: " << _requestLine.getMethod()
-                                                              << ", Path: " << _requestLine.getPath() << ", Version: " << _requestLine.getVersion());
-
-    return true;
+    if (_state == PARSING_COMPLETE)
+        return MESSAGE_COMPLETE;
+    return headersDoneNow ? HEADERS_COMPLETE : NEED_MORE;
 }
 
-/*
-Parse HTTP headers using the HTTPHeaders module
-
-iss Input string stream containing the headers section
-return true if parsing was successful, false otherwise
-*/
-bool HTTPparser::parseHeaders(std::istringstream &iss)
+// Collect the request line and header lines; returns the bytes consumed,
+// which stops right after the empty line that ends the header section
+size_t HTTPparser::feedHeaderSection(const char *data, size_t len)
 {
-    // Use HTTPHeaders module to parse all headers (reads lines until an
-    // empty line, which signifies the end of the header section).
-    if (!_headers.parseHeaders(iss))
+    size_t pos = 0;
+    while (pos < len && !_headersDone && _state != ERROR)
     {
-        setError("Invalid headers: " + _headers.getErrorMessage(), "400");
-        return false;
-    }
+        // One pass finds the LF and the ':' of a header field
+        size_t colon = std::string::npos;
+        size_t end = pos + HTTPScanner::findLineEnd(data + pos, len - pos, colon);
+        bool lf = end < len;
+        if (lf)
+            ++end;
+        std::string &raw = _headers.raw();
+        if (raw.size() + (end - pos) > HTTP_MAX_HEADER_SIZE)
+        {
+            setError("Request header section too large", "400");
+            return end;
+        }
+        if (colon != std::string::npos && _colon == std::string::npos)
+            _colon = raw.size() + colon;
+        raw.append(data + pos, end - pos);
+        pos = end;
+        if (!lf)
+            break; // Rest of the line comes with the next recv()
 
-    DEBUG_PRINT("Successfully parsed " << _headers.getHeaderCount() << " headers");
+        // The line without its CRLF
+        size_t lineStart = _lineStart;
+        size_t lineLen = raw.size() - 1 - lineStart;
+        if (lineLen > 0 && raw[lineStart + lineLen - 1] == '\r')
+            --lineLen;
+        size_t lineColon = _colon;
+        _lineStart = raw.size();
+        _colon = std::string::npos;
+        if (!parseHeaderSectionLine(lineStart, lineLen, lineColon))
+            break;
+    }
+    return pos;
+}
 
-    // Log important headers for debugging
-    if (_headers.hasContentLength())
+bool HTTPparser::parseHeaderSectionLine(size_t offset, size_t len, size_t colon)
+{
+    if (_state == PARSING_REQUEST_LINE)
     {
-        DEBUG_PRINT("Content-Length: " << _headers.getContentLength());
+        // Robustness (RFC 7230 3.5): ignore empty lines before a request,
+        // e.g. a stray CRLF a client sent after the previous body
+        if (len == 0)
+        {
+            _headers.raw().clear();
+            _lineStart = 0;
+            return true;
+        }
+        // Use HTTPRequestLine module to parse the line in place
+        const char *line = _headers.raw().data() + offset;
+        if (!_requestLine.parseRequestLine(line, len))
+        {
+            setError("Invalid request line: " + _requestLine.getErrorMessage(), "400");
+            return false;
+        }
+        if (!_uri.parse(line + _requestLine.getTargetOffset(), _requestLine.getTargetLength()))
+        {
+            setError("Invalid request target: " + _uri.getErrorMessage(), "400");
+            return false;
+        }
+        setState(PARSING_HEADERS);
+        return true;
     }
-    if (_headers.isChunked())
+
+    if (len > 0)
     {
-        DEBUG_PRINT("Transfer-Encoding: chunked detected");
+        if (!_headers.parseHeaderLine(offset, len, colon))
+        {
+            setError("Invalid headers: " + _headers.getErrorMessage(), "400");
+            return false;
+        }
+        return true;
     }
-    if (!_headers.getHost().empty())
+
+    // Empty line indicates end of headers
+    if (!_headers.finishHeaders())
     {
-        DEBUG_PRINT("Host: " << _headers.getHost());
+        setError("Invalid headers: " + _headers.getErrorMessage(), "400");
+        return false;
     }
+    DEBUG_PRINT("Successfully parsed " << _headers.getHeaderCount() << " headers");
     // Get parsed values from HTTPHeaders instead of parsing here
     _serverName = _headers.getHostName();
     _serverPort = _headers.getHostPort();
-
+    startBody();
     return true;
 }
 
-    /*
-    Parse HTTP body with support for Content-Length and chunked encoding
-
-    Handles three cases:
-    - Transfer-Encoding: chunked
-    - Content-Length: N
-    - No explicit length (reads remaining stream)
-
-iss Input string stream containing the body section
-return true if parsing was successful, false otherwise
-*/
-bool HTTPparser::parseBody(std::istringstream &iss)
+// Decide the body framing from the parsed headers. If both Content-Length
+// and Transfer-Encoding are present, Transfer-Encoding takes precedence.
+void HTTPparser::startBody()
 {
-    // Delegate body parsing to HTTPBody for modularity. HTTPBody decides
-    // between Content-Length or Transfer-Encoding: chunked and consumes
-    // the remainder of the input stream accordingly.
-    setState(_headers.isChunked() ? PARSING_CHUNKED_BODY : PARSING_BODY);
-
-    HTTPBody bodyParser;
-    if (!bodyParser.parse(iss, _headers, _requestLine.getMethod()))
+    _headersDone = true;
+    if (_headers.isChunked())
     {
-        setError(bodyParser.getErrorMessage(), "400");
-        return false;
+        DEBUG_PRINT("Transfer-Encoding: chunked detected");
+        _line.clear();
+        setState(PARSING_CHUNK_SIZE);
     }
-    _body = bodyParser.getBody();
-    if (!_body.empty())
+    else if (_headers.hasContentLength() && _headers.getContentLength() > 0)
     {
-        DEBUG_PRINT("Parsed body with " << _body.length() << " bytes");
+        DEBUG_PRINT("Content-Length: " << _headers.getContentLength());
+        _remaining = _headers.getContentLength();
+        if (_maxBodySize != 0 && _remaining > _maxBodySize)
+        {
+            // Known before any of it arrives: answer now instead of
+            // reading the body only to drop it
+            _bodyTooLarge = true;
+            setError("Request body larger than client_max_body_size", "413");
+            return;
+        }
+        if (_remaining <= HTTP_BODY_RESERVE_MAX)
+            _body.reserve(_remaining);
+        setState(PARSING_BODY);
     }
-    return true;
+    else
+        complete();
 }
 
-    /*
-    Main method to parse an HTTP request using modular components
-
-    High-level algorithm (HTTP/1.1):
-    1) Request-line: "METHOD SP request-target SP HTTP-version CRLF"
-    2) Header section: 1+ header fields each ending with CRLF
-        - Terminates with an empty line (i.e., the CRLF after the last header
-          is immediately followed by another CRLF)
-    3) Message body (optional): determined by either
-        - Transfer-Encoding: chunked (chunked framing), or
-        - Content-Length: N (fixed-length), or
-        - Absent (read until EOF if used over a raw TCP stream; for this parser,
-          we consume whatever remains in the stringstream when neither header is
-          present)
-
-    This method orchestrates the parsing process using specialized classes:
-    - HTTPRequestLine for parsing the first line
-    - HTTPHeaders for parsing header section (stops on the empty line)
-    - HTTPBody for parsing the body
-
-    The method operates as a state machine to reflect progress and to make it
-    easier to evolve toward incremental, non-blocking parsing (poll/epoll).
-
-    rawRequest The raw HTTP request string to parse
-    return true if parsing was successful, false otherwise
-    */
-    bool HTTPparser::parseRequest(const std::string &rawRequest)
+// Take body bytes according to the framing; returns the bytes consumed
+size_t HTTPparser::feedBody(const char *data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len)
     {
-        // Reset parser state and keep a copy of the raw request for debugging
-        reset();
-        _HTTPrequest = rawRequest; // Store for debugging/logging
-
-        DEBUG_PRINT(MAGENTA << "~~~ Starting HTTP Request Parsing ~~~" << RESET);
-        DEBUG_PRINT("Raw Request (first 200 chars): " << rawRequest.substr(0, 200));
-
-        // We parse from a stringstream for simplicity. In a real server with
-        // non-blocking sockets, feed incremental buffers and maintain
-        // parsing state across calls.
-        std::istringstream iss(rawRequest);
-
-        // State machine implementation
-        setState(PARSING_REQUEST_LINE);
-
-        // Step 1: Parse request line
-        if (_state == PARSING_REQUEST_LINE)
+        if (_state == PARSING_BODY || _state == PARSING_CHUNK_DATA)
         {
-            if (!parseRequestLine(iss))
+            size_t n = std::min(_remaining, len - pos);
+            if (_maxBodySize != 0 && _body.size() + n > _maxBodySize)
             {
-                setState(ERROR);
-                return false;
+                // Only a chunked body gets here (a Content-Length over the
+                // limit is refused in startBody()): it is over the limit
+                // once the decoded size is
+                _bodyTooLarge = true;
+                _body.reset();
             }
-            setState(PARSING_HEADERS);
-        }
-
-        // Step 2: Parse headers
-        if (_state == PARSING_HEADERS)
-        {
-            if (!parseHeaders(iss))
+            if (!_bodyTooLarge && !_body.append(data + pos, n))
             {
-                setState(ERROR);
-                return false;
+                setError(_body.getErrorMessage(), "500");
+                return pos + n;
             }
-            setState(PARSING_BODY);
+            _remaining -= n;
+            pos += n;
+            if (_remaining > 0)
+                continue;
+            if (_state == PARSING_BODY)
+                complete();
+            else
+                setState(PARSING_CHUNK_DATA_END);
         }
-
-        // Step 3: Parse body (if present)
-        if (_state == PARSING_BODY)
+        else if (_state == PARSING_CHUNK_SIZE || _state == PARSING_CHUNK_DATA_END || _state == PARSING_TRAILERS)
         {
-            if (!parseBody(iss))
+            // Line-oriented parts of the chunked coding
+            const char *lf = static_cast<const char *>(std::memchr(data + pos, '\n', len - pos));
+            size_t end = lf ? static_cast<size_t>(lf - data) : len;
+            if (_line.size() + (end - pos) > HTTP_MAX_CHUNK_LINE)
             {
-                setState(ERROR);
-                return false;
+                setError("Chunk size or trailer line too long", "400");
+                return end;
             }
-            setState(PARSING_COMPLETE);
+            _line.append(data + pos, end - pos);
+            pos = end;
+            if (!lf)
+                break;
+            ++pos; // the LF
+            trimTrailingCR(_line);
+            if (!parseBodyLine(_line))
+                return pos;
+            _line.clear();
         }
+        else
+            break; // PARSING_COMPLETE or ERROR: the rest is not ours
+    }
+    return pos;
+}
 
-        // Final state check
-        if (_state == PARSING_COMPLETE)
+/*
+    RFC 7230 chunked coding:
+     chunk = chunk-size [; chunk-ext] CRLF
+             chunk-data CRLF
+     last-chunk = 1*('0') [; chunk-ext] CRLF
+                  trailer-section CRLF
+*/
+bool HTTPparser::parseBodyLine(const std::string &line)
+{
+    if (_state == PARSING_CHUNK_SIZE)
+    {
+        size_t chunkSize = 0;
+        if (!_body.parseChunkSize(line, chunkSize))
         {
-            _isValid = true;
-            DEBUG_PRINT(MAGENTA << "~~~ HTTP Request Parsing Complete ~~~" << RESET);
-            DEBUG_PRINT("Method: " << getMethod() << ", Path: " << getPath()
-                                   << ", Version: " << getVersion());
-            DEBUG_PRINT("Headers: " << getHeaders().size() << " total");
-            if (!_body.empty())
-            {
-                DEBUG_PRINT("Body: " << _body.length() << " characters");
-            }
-            return true;
+            setError(_body.getErrorMessage(), "400");
+            return false;
         }
-        else if (_state == ERROR)
+        _remaining = chunkSize;
+        setState(chunkSize == 0 ? PARSING_TRAILERS : PARSING_CHUNK_DATA);
+        return true;
+    }
+    if (_state == PARSING_CHUNK_DATA_END)
+    {
+        // Each chunk is followed by CRLF
+        if (!line.empty())
         {
-            DEBUG_PRINT(MAGENTA << "~~~ HTTP Request Parsing Failed ~~~" << RESET);
-            DEBUG_PRINT("Error: " << _errorMessage);
+            setError("Missing CRLF after chunk data", "400");
             return false;
         }
+        setState(PARSING_CHUNK_SIZE);
+        return true;
+    }
+    // Trailer headers are skipped; an empty line ends the message
+    if (line.empty())
+    {
+        DEBUG_PRINT("Finished parsing chunked body, total size: " << _body.size());
+        complete();
+    }
+    return true;
+}
 
-        // Should not reach here
-        setError("Unexpected parser state", "500");
-        return false;
+void HTTPparser::complete()
+{
+    if (_bodyTooLarge)
+    {
+        setError("Request body larger than client_max_body_size", "413");
+        return;
+    }
+    setState(PARSING_COMPLETE);
+    _isValid = true;
+    DEBUG_PRINT(MAGENTA << "~~~ HTTP Request Parsing Complete ~~~" << RESET);
+    DEBUG_PRINT("Method: " << getMethod() << ", Path: " << getPath()
+                           << ", Version: " << getVersion());
+    DEBUG_PRINT("Headers: " << _headers.getHeaderCount() << " total");
+    if (_body.size() > 0)
+    {
+        DEBUG_PRINT("Body: " << _body.size() << " characters");
     }
+}
+
+// The connection is done sending: whatever is still missing is an error
+bool HTTPparser::finish()
+{
+    if (_state == PARSING_COMPLETE || _state == ERROR)
+        return _isValid;
+    if (_state == PARSING_REQUEST_LINE && _headers.raw().empty())
+        setError("No request line found", "400");
+    else if (!_headersDone)
+        setError("Incomplete header section", "400");
+    else if (_state == PARSING_BODY)
+        setError("Body shorter than Content-Length", "400");
+    else
+        setError("Unexpected end of input in chunked body", "400");
+    return false;
+}
+
+/*
+    Parse a whole request held in one string (e.g. tests and benchmarks);
+    the connection code uses feed() instead.
+
+    rawRequest The raw HTTP request string to parse
+    return true if parsing was successful, false otherwise
+*/
+bool HTTPparser::parseRequest(const std::string &rawRequest)
+{
+    reset();
+    DEBUG_PRINT(MAGENTA << "~~~ Starting HTTP Request Parsing ~~~" << RESET);
+    DEBUG_PRINT("Raw Request (first 200 chars): " << rawRequest.substr(0, 200));
+    feed(rawRequest.data(), rawRequest.size());
+    return finish();
+}
@@ -3,19 +3,27 @@
 
 // Reset the parser to initial state
 // Clears all internal state to prepare for a fresh parse. This method
-// is called by the constructor and at the start of parseRequest.
+// is called by the constructor, before the next request of a keep-alive
+// connection and at the start of parseRequest.
 void HTTPparser::reset()
 {
     _state = PARSING_REQUEST_LINE;
-    _HTTPrequest.clear();
     _requestLine.reset();
+    _uri.reset();
     _headers.reset();
-    _body.clear();
-    _buffer.clear();
+    _body.reset();
+    _lineStart = 0;
+    _colon = std::string::npos;
+    _headersDone = false;
+    _line.clear();
+    _remaining = 0;
+    _consumed = 0;
+    _bodyTooLarge = false;
     _errorStatusCode.clear();
     _isValid = false;
     _errorMessage.clear();
     _currentFilePath.clear();
+    _currentLocation = NULL;
     _serverName.clear();
     _serverPort.clear();
 }
@@ -34,7 +42,7 @@ void HTTPparser::setError(const std::string& message, const std::string& statusC
 }
 
 // Set the internal parser state
-// Only sets the enum; transitions are managed in parseRequest.
+// Only sets the enum; transitions are managed in feed().
 void HTTPparser::setState(State s)
 {
     _state = s;
@@ -1,13 +1,14 @@
 #include "Common.hpp"
+#include "Logger.hpp"
 
-Response::Response(HttpServer &HttpServer, HTTPparser &HTTPParser, ConfigParser &ConfigParser, int serverIndex) :  _ServerIndex(serverIndex), _HttpServer(HttpServer), _HttpParser(HTTPParser), _ConfigParser(ConfigParser)
+Response::Response(const HttpServer &HttpServer, HTTPparser &HTTPParser, const ConfigParser &ConfigParser, int serverIndex,
+                   OpenFileCache &files, ContentCache &content) :  _ServerIndex(serverIndex), _file_fd(-1), _file_size(0), _cached(NULL), _HttpServer(HttpServer), _HttpParser(HTTPParser), _files(files), _content(content), _ConfigParser(ConfigParser)
 {
     _request = "";
     _targetfile = "";
     _response_headers = "";
     _response_body = "";
     _code = 0;
-    _response_final = " ";
     _loc = "";
 }
 
@@ -20,14 +21,15 @@ const Response& Response::operator=(const Response& other) {
             _response = other._response;
             body = other.body;
             _response_headers = other._response_headers;
-            _response_final = other._response_final;
             _request = other._request;
             _code = other._code;
             root = other.root;
-            _HttpServer = other._HttpServer;
-            _HttpParser = other._HttpParser;
-            _ConfigParser = other._ConfigParser;
+            // _HttpServer, _HttpParser and _ConfigParser are references and
+            // cannot be reseated; assigning through them would overwrite the
+            // referenced server/parser/config objects themselves.
             _ServerIndex = other._ServerIndex;
+            // _file_fd and _cached are not shared: other keeps (and
+            // closes or releases) them
 }
         return *this;
     }
@@ -50,11 +52,12 @@ void Response::appDate()
 void Response::appContentLen()
 {
     std::stringstream ss;
-    int size;
-    size = _response_body.size();
-    ss << size;
+    if (_file_fd != -1)
+        ss << _file_size;
+    else
+        ss << _response_body.size();
    // _response_headers.append((ss.str()) + "\r\n");
-    if (_response_body.empty())
+    if (_response_body.empty() && _file_fd == -1)
         _response_headers.append("Content-Length: 0");
     else
     {
@@ -141,6 +144,8 @@ void Response::statusLine()
         _response_headers.append(" Moved Permanently\r\n");
     else if (_code == 302)
         _response_headers.append(" Found\r\n");
+    else if (_code == 304)
+        _response_headers.append(" Not Modified\r\n");
     else if (_code == 405)
         _response_headers.append(" Method Not Allowed\r\n");
     else if (_code == 413)
@@ -165,6 +170,8 @@ std::string Response::statusMessage(int code)
         return "Moved Permanently";
     else if (code == 302)
         return "Found";
+    else if (code == 304)
+        return "Not Modified";
     else if (code == 405)
         return "Method Not Allowed";
     else if (code == 413)
@@ -175,9 +182,15 @@ std::string Response::statusMessage(int code)
         return "Unknown Status";
 }
 
+// The Client keeps the connection open exactly when this says so
+bool Response::keepAlive() const
+{
+    return (_code == 200 || _code == 304) && _HttpServer.determineKeepAlive(_HttpParser);
+}
+
 void Response::connection()
 {
-    if (_HttpServer.determineKeepAlive(_HttpParser) && _code == 200)
+    if (keepAlive())
         _response_headers.append("Connection: keep-alive\r\n");
     else
         _response_headers.append("Connection: close\r\n");
@@ -193,8 +206,8 @@ void Response::server()
 
 bool Response::fileExists(const std::string& name)
 {
-    std::ifstream f(name.c_str());
-    return f.good();
+    OpenFileCache::File info;
+    return _files.stat(name, info);
 }
 
 
@@ -222,14 +235,14 @@ bool Response::fileExists(const std::string& name)
 
 bool Response::isDirectory(std::string path)
 {
-    struct stat path_stat;
-    if(stat(path.c_str(), &path_stat)!=0)
+    OpenFileCache::File info;
+    if (!_files.stat(path, info))
     {
         return false;
     }
-     bool is_dir = S_ISDIR(path_stat.st_mode);
-    std::cout << "📁 Is directory: " << (is_dir ? "YES" : "NO") << std::endl;
-    
+    bool is_dir = info.isDir;
+    DEBUG_PRINT("Is directory: " << (is_dir ? "YES" : "NO"));
+
     return is_dir;
     /*if(stat(path.c_str(), &path_stat)!=0)
         return false;*/
@@ -238,10 +251,10 @@ bool Response::isDirectory(std::string path)
 
 int Response::appBody(const std::string &cgiOutput)
 {
-    const LocationConfig *currentLocation = _HttpServer.getCurrentLocation();
+    const LocationConfig *currentLocation = _HttpParser.getCurrentLocation();
     _targetfile = _HttpParser.getCurrentFilePath();
 
-    if (isDirectory(_targetfile) && currentLocation->autoindex)
+    if (isDirectory(_targetfile) && currentLocation && currentLocation->autoindex)
     {
         _response_body = generateDirectoryListing(_targetfile, _HttpParser.getPath());
         if(_response_body.empty())
@@ -254,22 +267,31 @@ int Response::appBody(const std::string &cgiOutput)
     }
     else if (_request == "GET")
     {
-        std::ifstream file(_targetfile.c_str());
-        if (file.fail())
+        // The validators come from the cached stat(): an unchanged file is
+        // answered without being opened, let alone read
+        if (_files.stat(_targetfile, _file_info) && _file_info.isReg && notModified())
         {
-            _code = 404;
-            return 1;
+            _code = 304;
+            return 0;
         }
-            std::ostringstream ss;
-            ss << file.rdbuf();
-            _response_body = ss.str();
-            file.close();
+        if (findCached())
+        {
             _code = 200;
             return 0;
+        }
+        // The body is not read here: takeOutput() queues the descriptor
+        // and the Client sends it with sendfile() (OutputQueue::pushFile())
+        if (!openFile(_targetfile))
+        {
+            _code = 404;
+            return 1;
+        }
+        _code = 200;
+        return 0;
     }
     else if (_request == "POST" || _request == "DELETE")
     {
-        if (currentLocation->cgiPass == true && !currentLocation->cgiExtension.empty() && (_HttpServer.isMethodAllowed(_request)))
+        if (currentLocation && currentLocation->cgiPass == true && !currentLocation->cgiExtension.empty() && (_HttpServer.isMethodAllowed(currentLocation, _request)))
         {
             if(fileExists(_targetfile) == false)
             {
@@ -317,6 +339,116 @@ void Response::buildErrorPage(int code)
                                                                     "</body></html>");
 }
 
+// Take the regular file at path as the body (see takeOutput()). An empty
+// file leaves no descriptor behind. False if there is no such file.
+bool Response::openFile(const std::string &path)
+{
+    OpenFileCache::File info;
+    int fd = _files.open(path, info);
+    if (fd == -1)
+        return false;
+    if (info.size == 0)
+    {
+        close(fd); // nothing to send
+        return true;
+    }
+    _file_fd = fd;
+    _file_size = info.size;
+    _file_info = info;
+    return true;
+}
+
+// Whole response for the file in _file_info from the content cache, if it
+// was rendered from the file as it is now (see takeOutput())
+bool Response::findCached()
+{
+    size_t limit = cacheLimit();
+    if (!_content.enabled() || limit == 0 || !_file_info.isReg || static_cast<size_t>(_file_info.size) > limit)
+        return false;
+    _cached = _content.acquire(cacheKey(), _file_info);
+    return _cached != NULL;
+}
+
+// Does the client's copy of the file in _file_info still match?
+// If-None-Match takes precedence: If-Modified-Since is ignored with it.
+bool Response::notModified() const
+{
+    const HTTPHeaders &headers = _HttpParser.getHeaders();
+    size_t len;
+    const char *value = headers.findHeader(HEADER_IF_NONE_MATCH, len);
+    if (value != NULL)
+        return etagListMatches(value, len, makeETag(_file_info));
+    time_t since;
+    value = headers.findHeader(HEADER_IF_MODIFIED_SINCE, len);
+    return value != NULL && parseHttpDate(value, len, since) && _file_info.mtime <= since;
+}
+
+// Last-Modified, ETag and the location's Cache-Control of a static file
+void Response::appValidators()
+{
+    if ((_code != 200 && _code != 304) || !_file_info.isReg)
+        return;
+    _response_headers.append("Last-Modified: " + httpDate(_file_info.mtime) + "\r\n");
+    _response_headers.append("ETag: " + makeETag(_file_info) + "\r\n");
+
+    const LocationConfig *loc = _HttpParser.getCurrentLocation();
+    if (loc == NULL || loc->expires == EXPIRES_OFF)
+        return;
+    if (loc->expires == EXPIRES_EPOCH)
+        _response_headers.append("Cache-Control: no-cache\r\n");
+    else
+    {
+        std::ostringstream oss;
+        oss << "Cache-Control: max-age=" << loc->expires << "\r\n";
+        _response_headers.append(oss.str());
+    }
+}
+
+// Read the opened file behind a copy of the headers and keep the whole
+// response for the next request for it. The file stays the body if it
+// cannot be read or the response does not fit the cache.
+void Response::storeCached()
+{
+    std::string response;
+    response.reserve(_response_headers.size() + static_cast<size_t>(_file_size));
+    response = _response_headers;
+    size_t headers = response.size();
+    response.resize(headers + static_cast<size_t>(_file_size));
+    off_t done = 0;
+    while (done < _file_size)
+    {
+        ssize_t n = pread(_file_fd, &response[headers + done], static_cast<size_t>(_file_size - done), done);
+        if (n <= 0) // changed under us: leave it to sendfile() and the next request
+            return;
+        done += n;
+    }
+    _cached = _content.insert(cacheKey(), _file_info, response, headers);
+    if (_cached == NULL)
+        return;
+    close(_file_fd);
+    _file_fd = -1;
+    _response_headers.clear(); // part of the cached response
+}
+
+// Everything a cached response depends on besides the file: the server
+// block, the Connection header and the Cache-Control header (the expires
+// of the location, which differs between locations serving the same file)
+std::string Response::cacheKey() const
+{
+    const LocationConfig *loc = _HttpParser.getCurrentLocation();
+    std::ostringstream key;
+    key << _ServerIndex << (_HttpServer.determineKeepAlive(_HttpParser) ? " k " : " c ")
+        << (loc ? loc->expires : EXPIRES_OFF) << ' ' << _targetfile;
+    return key.str();
+}
+
+// Largest file whose response the location caches, 0 if it caches none
+size_t Response::cacheLimit() const
+{
+    const LocationConfig *loc = _HttpParser.getCurrentLocation();
+    return loc ? loc->contentCacheMax : CONTENT_CACHE_DEFAULT_FILE_MAX;
+}
+
 int Response::stringToInt(const std::string &str)
 {
     std::stringstream ss(str);
@@ -337,14 +469,8 @@ void Response::builderror_responses(int code)
     else
     {
         std::string path = _ConfigParser.getServers().at(_srvIndx).getRoot() + _ConfigParser.getServers().at(_srvIndx).getErrorPage(code); //server based on host and port
-        if (fileExists(path))
-        {
-            std::ifstream file(path.c_str());
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            _response_body = buffer.str();
-            file.close();
-        }
+        if (openFile(path))
+            _response_body.clear(); // sent from the file like any static file
         else
             buildErrorPage(404);
     }
@@ -353,7 +479,7 @@ void Response::builderror_responses(int code)
 std::string Response::redirecUtil()
 {
     std::string _response_headers;
-    std::map<int, std::string> redirec = _HttpServer.getCurrentLocation()->redirect;
+    std::map<int, std::string> redirec = _HttpParser.getCurrentLocation()->redirect;
     std::map<int, std::string>::iterator it = redirec.begin();
     if (it != redirec.end())
     {
@@ -376,7 +502,7 @@ std::string Response::redirecUtil()
 
 void Response::buildResponse(const std::string &cgiOutput)
 {
-    const LocationConfig *loc = _HttpServer.getCurrentLocation();
+    const LocationConfig *loc = _HttpParser.getCurrentLocation();
 
     // 1) If parser/request-level error exists, respond with error immediately.
     //    reqErr() consults parser error status and _code.
@@ -384,7 +510,6 @@ void Response::buildResponse(const std::string &cgiOutput)
     {
         builderror_responses(_code);
         setHeaders();
-        _response_final = _response_headers + _response_body;
         return;
     }
 
@@ -392,9 +517,9 @@ void Response::buildResponse(const std::string &cgiOutput)
     //    should not override a parser-detected error).
     if (loc && !loc->redirect.empty())
     {
-        _response_final = redirecUtil(); // redirecUtil sets _code and builds full headers
+        _response_headers = redirecUtil(); // redirecUtil sets _code and builds full headers
         DEBUG_PRINT("Redirect response built:\n"
-                    << _response_final);
+                    << _response_headers);
         return;
     }
 
@@ -403,9 +528,12 @@ void Response::buildResponse(const std::string &cgiOutput)
     {
         builderror_responses(_code);
     }
-    // Set the final response string
+    else if (_cached != NULL)
+        return; // sent from the cache as it is
+    // Headers for the body in _response_body or _file_fd
     setHeaders();
-    _response_final = _response_headers + _response_body;
+    if (_code == 200 && _file_fd != -1 && static_cast<size_t>(_file_size) <= cacheLimit() && _content.enabled())
+        storeCached();
 }
 
 void Response::setHeaders()
@@ -419,12 +547,17 @@ void Response::setHeaders()
     // server();
     // appDate();
 
-    // Content-Type (ensure a default if appContentType didn't add one)
-    appContentType();
-    if (_response_headers.find("Content-Type:") == std::string::npos)
-        _response_headers.append("Content-Type: text/html; charset=utf-8\r\n");
+    // A 304 has no body to describe
+    if (_code != 304)
+    {
+        // Content-Type (ensure a default if appContentType didn't add one)
+        appContentType();
+        if (_response_headers.find("Content-Type:") == std::string::npos)
+            _response_headers.append("Content-Type: text/html; charset=utf-8\r\n");
 
-    appContentLen();
+        appContentLen();
+    }
+    appValidators();
 
     connection();
     _response_headers.append("\r\n");
@@ -445,9 +578,9 @@ void Response::setHeaders()
 int Response::reqErr()
 {
     // Error code set from HTTPparser during request parsing
-    if (!request.getErrorStatusCode().empty())
+    if (!_HttpParser.getErrorStatusCode().empty())
     {
-        _code = std::atoi(request.getErrorStatusCode().c_str());
+        _code = std::atoi(_HttpParser.getErrorStatusCode().c_str());
         return 1;
     }
     // If response code indicates an error eg. from CGI checks, return 1
@@ -456,14 +589,36 @@ int Response::reqErr()
     return 0;
 }
 
-std::string Response::processResponse(std::string request, int code, const std::string &cgiOutput)
+void Response::processResponse(std::string request, int code, const std::string &cgiOutput)
 {
     setStatusCode(code);
     setRequest(request);
     buildResponse(cgiOutput);
-    return _response_final;
+}
+
+void Response::takeOutput(OutputQueue &out)
+{
+    if (_cached != NULL)
+    {
+        Logger::logResponse(_cached->data(), _cached->headerLength()); // not the body
+        out.push(_cached);
+        _cached = NULL;
+        return;
+    }
+    Logger::logResponse(_response_headers, _response_body);
+    out.push(_response_headers);
+    out.push(_response_body);
+    if (_file_fd != -1)
+    {
+        out.pushFile(_file_fd, _file_size);
+        _file_fd = -1;
+    }
 }
 
 Response::~Response()
 {
+    if (_file_fd != -1)
+        close(_file_fd);
+    if (_cached != NULL)
+        ContentCache::release(_cached);
 }
@@ -2,6 +2,8 @@
 #include <dirent.h>
 #include <cstring>*/
 #include "Common.hpp"
+#include <algorithm>
+#include <time.h>
 
 std::string generateDirectoryListing(std::string path, std::string requestPath)
 {
@@ -45,4 +47,78 @@ for (size_t i = 0; i < distlist_page.size(); i++) {
 std::cout << "==================" << std::endl;*/
     return distlist_page;
    // std::cout << distlist_page << std::endl;
-}       
\ No newline at end of file
+}
+
+// IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string httpDate(time_t t)
+{
+    struct tm tm;
+    char buf[64];
+    gmtime_r(&t, &tm);
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+// An HTTP-date in any of the three formats recipients must accept
+// (IMF-fixdate, RFC 850, asctime). False if value is none of them.
+bool parseHttpDate(const char *value, size_t len, time_t &t)
+{
+    static const char *formats[] = {"%a, %d %b %Y %H:%M:%S GMT", "%A, %d-%b-%y %H:%M:%S GMT", "%a %b %e %H:%M:%S %Y"};
+    char buf[64];
+    if (len >= sizeof(buf))
+        return false;
+    memcpy(buf, value, len);
+    buf[len] = '\0';
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+    {
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        const char *end = strptime(buf, formats[i], &tm);
+        if (end != NULL && *end == '\0')
+        {
+            t = timegm(&tm);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Strong validator of a static file: changes with its mtime, its size and
+// when it is replaced by another file (inode)
+std::string makeETag(const OpenFileCache::File &file)
+{
+    std::ostringstream oss;
+    oss << std::hex << '"' << static_cast<unsigned long>(file.mtime) << '-'
+        << static_cast<unsigned long>(file.size) << '-' << static_cast<unsigned long>(file.ino) << '"';
+    return oss.str();
+}
+
+// If-None-Match: "*" or a comma separated list of entity tags, compared
+// weakly (a W/ prefix is ignored) as RFC 9110 asks for this header
+bool etagListMatches(const char *list, size_t len, const std::string &etag)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        while (i < len && (list[i] == ' ' || list[i] == '\t' || list[i] == ','))
+            ++i;
+        if (i == len)
+            break;
+        if (list[i] == '*')
+            return true;
+        if (len - i > 2 && list[i] == 'W' && list[i + 1] == '/')
+            i += 2;
+        size_t start = i;
+        if (list[i] == '"')
+        {
+            i = std::find(list + i + 1, list + len, '"') - list;
+            if (i < len)
+                ++i; // the closing quote belongs to the tag
+        }
+        else
+            i = std::find(list + i, list + len, ',') - list;
+        if (etag.compare(0, std::string::npos, list + start, i - start) == 0)
+            return true;
+    }
+    return false;
+}
@@ -37,5 +37,6 @@ int main(int argc, char **argv)
     if (!parser.parse(configPath))
         return 1;
     HttpServer server(parser);
+    server.setCommandLine(argc, argv);
     return server.start();
 }
@@ -1,218 +1,265 @@
 #include "Common.hpp"
 #include "HttpServer.hpp"
+#include "Reactor.hpp"
 #include "Client.hpp"
 
-/* Multi-client accept loop using select().
-   - Monitors the listening socket for new connections
-   - Monitors each client socket based on its state (READING/WRITING)
-   - Delegates state transitions to Client::handleConnection()
+/* Accepting connections and distributing them over the reactors.
+   - worker_threads 1: one Reactor on the calling thread owns the listening
+     sockets and adopts its connections directly
+   - worker_threads N: N Reactor threads; this thread runs a small accept
+     loop and posts every new connection to the least-loaded reactor
 */
 
-int HttpServer::runMultiServerAcceptLoop(const std::vector<ServerSocketInfo> &serverSockets)
+// Pick the reactor with the fewest connections. The scan starts one past
+// the previous pick so ties (e.g. an idle server) are broken round-robin.
+Reactor *HttpServer::pickReactor()
 {
-
-    while (!g_stop)
+    size_t count = _reactors.size();
+    size_t best = _nextReactor % count;
+    size_t bestLoad = _reactors[best]->load();
+    for (size_t i = 1; i < count && bestLoad > 0; ++i)
     {
-        fd_set read_fds;
-        fd_set write_fds;
-        FD_ZERO(&read_fds);
-        FD_ZERO(&write_fds);
+        size_t idx = (_nextReactor + i) % count;
+        size_t l = _reactors[idx]->load();
+        if (l < bestLoad)
+        {
+            best = idx;
+            bestLoad = l;
+        }
+    }
+    _nextReactor = best + 1;
+    return _reactors[best];
+}
 
-        int max_fd = -1;
+// Connections owned by this process: the owner alone in single-threaded
+// mode, every reactor (including queued handoffs) otherwise
+size_t HttpServer::connectionCount(Reactor *owner) const
+{
+    if (owner != NULL)
+        return owner->load();
+    size_t total = 0;
+    for (size_t i = 0; i < _reactors.size(); ++i)
+        total += _reactors[i]->load();
+    return total;
+}
 
-        // Add ALL server sockets to read set (instead of single server_fd)
-        for (size_t i = 0; i < serverSockets.size(); ++i)
+// Accept one descriptor, non-blocking and close-on-exec from the start
+static int acceptNonBlocking(int listenFd)
+{
+    struct sockaddr_in cli;
+    socklen_t clilen = sizeof(cli);
+#ifdef __linux__
+    return accept4(listenFd, (struct sockaddr *)&cli, &clilen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    int cfd = accept(listenFd, (struct sockaddr *)&cli, &clilen);
+    if (cfd >= 0)
+    {
+        fcntl(cfd, F_SETFD, FD_CLOEXEC);
+        if (!HttpServer::setNonBlocking(cfd))
         {
-            int server_fd = serverSockets[i].socket_fd;
-            FD_SET(server_fd, &read_fds);
-            if (server_fd > max_fd)
-                max_fd = server_fd;
+            close(cfd);
+            errno = EAGAIN; // dropped; try the next one on the next wakeup
+            return -1;
         }
+    }
+    return cfd;
+#endif
+}
 
-        // Add client FDs based on their current state
-        for (std::map<int, Client *>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+bool HttpServer::acceptConnections(const ServerSocketInfo &info, Reactor *owner)
+{
+    // Bounded batch: the rest stays in the backlog until the next wakeup,
+    // so a connection storm cannot starve the established connections
+    for (size_t n = 0; n < ACCEPT_BATCH; ++n)
+    {
+        if (connectionCount(owner) >= _workerConnections)
         {
-            int cfd = it->first;
-            Client *cl = it->second;
-            ClientState st = cl->getState();
-            if (st == READING)
-            {
-                FD_SET(cfd, &read_fds);
-                if (cfd > max_fd)
-                    max_fd = cfd;
-            }
-            else if (st == WRITING)
-            {
-                FD_SET(cfd, &write_fds);
-                if (cfd > max_fd)
-                    max_fd = cfd;
-            }
-            else if (st == CGI_WRITING_INPUT)
-            {
-                int cgi_in = cl->getCgiInputFd();
-                if (cgi_in != -1)
-                {
-                    FD_SET(cgi_in, &write_fds);
-                    if (cgi_in > max_fd)
-                        max_fd = cgi_in;
-                }
-                // Also monitor CGI stdout so we can drain it while feeding stdin.
-                int cgi_out = cl->getCgiOutputFd();
-                if (cgi_out != -1)
-                {
-                    FD_SET(cgi_out, &read_fds);
-                    if (cgi_out > max_fd)
-                        max_fd = cgi_out;
-                }
-            }
-            else if (st == CGI_READING_OUTPUT)
+            DEBUG_PRINT("worker_connections limit (" << _workerConnections << ") reached, pausing accept");
+            return false;
+        }
+
+        int cfd = acceptNonBlocking(info.socket_fd);
+        if (cfd < 0)
+        {
+            if (errno == EINTR) // Interrupted by signal, retry
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) // No more connections available
+                break;
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
             {
-                int cgi_out = cl->getCgiOutputFd();
-                if (cgi_out != -1)
-                {
-                    FD_SET(cgi_out, &read_fds);
-                    if (cgi_out > max_fd)
-                        max_fd = cgi_out;
-                }
+                // Out of descriptors/memory: leave the backlog alone for a
+                // while instead of spinning on a listener that stays ready
+                std::cerr << "accept() failed on server socket " << info.socket_fd
+                          << ": " << strerror(errno) << ", pausing accept" << std::endl;
+                return false;
             }
+            // Connection aborted before it was accepted etc.
+            DEBUG_PRINT("accept() failed on server socket " << info.socket_fd << ": " << strerror(errno));
+            continue;
+        }
+
+        DEBUG_PRINT("New connection accepted on server '"
+                    << _servers[info.serverIndex].getServerName()
+                    << "' port " << info.port << " (fd: " << RED << cfd << RESET << ")");
+        if (owner != NULL)
+            owner->adopt(cfd, info);
+        else
+            pickReactor()->post(cfd, info);
+    }
+    return true;
+}
+
+static void *reactorThread(void *arg)
+{
+    Reactor *reactor = static_cast<Reactor *>(arg);
+    std::vector<HttpServer::ServerSocketInfo> noListeners;
+    reactor->run(noListeners);
+    return NULL;
+}
+
+// Main thread of the threaded mode: accept and hand off, nothing else.
+int HttpServer::runThreadedAcceptLoop(const std::vector<ServerSocketInfo> &serverSockets)
+{
+    EventLoop acceptLoop;
+    if (!acceptLoop.init())
+    {
+        std::cerr << "Failed to initialise " << acceptLoop.backendName() << " event loop" << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < serverSockets.size(); ++i)
+    {
+        if (!acceptLoop.add(serverSockets[i].socket_fd, EventLoop::EV_READ))
+        {
+            std::cerr << "Failed to register server socket " << serverSockets[i].socket_fd << std::endl;
+            return 1;
         }
+    }
 
-        struct timeval tv;
-        tv.tv_sec = 1; // Periodic timeout to honor shutdown
-        tv.tv_usec = 0;
+    // Stop signals must land on this thread: the reactor threads inherit
+    // a mask that blocks them.
+    sigset_t stopSignals;
+    sigset_t oldMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigaddset(&stopSignals, SIGQUIT);
+    sigaddset(&stopSignals, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &oldMask);
 
-        int ready = select(max_fd + 1, &read_fds, &write_fds, NULL, &tv);
+    std::vector<pthread_t> threads;
+    int result = 0;
+    for (size_t i = 0; i < _reactors.size(); ++i)
+    {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, reactorThread, _reactors[i]) != 0)
+        {
+            std::cerr << "Failed to start reactor thread " << i << std::endl;
+            g_stop = 1;
+            result = 1;
+            break;
+        }
+        threads.push_back(tid);
+    }
+    pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+    DEBUG_PRINT("Started " << threads.size() << " reactor threads");
+
+    // While paused (worker_connections reached or out of fds) the listeners
+    // leave the loop and the reactors' load is polled instead
+    bool paused = false;
+    bool draining = false; // SIGQUIT received
+    sig_atomic_t upgradeSeen = g_upgradeRequest;
+    while (!g_stop)
+    {
+        if (upgradeSeen != g_upgradeRequest)
+        {
+            upgradeSeen = g_upgradeRequest;
+            if (!draining)
+                spawnUpgrade();
+        }
+        if (g_graceful && !draining)
+        {
+            for (size_t s = 0; s < serverSockets.size() && !paused; ++s)
+                acceptLoop.remove(serverSockets[s].socket_fd);
+            stopListening();
+            draining = true;
+            // The reactors close their idle connections themselves
+            for (size_t i = 0; i < threads.size(); ++i)
+                _reactors[i]->wakeup();
+        }
+        if (draining)
+        {
+            if (connectionCount(NULL) == 0)
+                break;
+            usleep(ACCEPT_RESUME_POLL_MS * 1000);
+            continue;
+        }
+        int ready = acceptLoop.wait(paused ? ACCEPT_RESUME_POLL_MS : 1000); // Periodic timeout to honor shutdown
         if (ready < 0)
         {
             if (errno == EINTR) // Interrupted by signal, retry
                 continue;
-            std::cerr << "select() failed" << std::endl;
+            std::cerr << "event loop wait() failed" << std::endl;
+            result = 1;
             break;
         }
-
-        // Accept connections from ANY server socket that's ready
-        for (size_t i = 0; i < serverSockets.size(); ++i)
+        if (paused)
         {
-            int server_fd = serverSockets[i].socket_fd;
-
-            if (FD_ISSET(server_fd, &read_fds))
-            {
-                while (true)
-                {
-                    struct sockaddr_in cli;
-                    socklen_t clilen = sizeof(cli);
-                    int cfd = accept(server_fd, (struct sockaddr *)&cli, &clilen);
-                    if (cfd < 0)
-                    {
-                        if (errno == EINTR) // Interrupted by signal, retry
-                            continue;
-                        if (errno == EAGAIN || errno == EWOULDBLOCK) // No more connections available
-                            break;
-                        std::cerr << "accept() failed on server socket " << i << std::endl;
-                        break;
-                    }
-
-                    if (!HttpServer::setNonBlocking(cfd))
-                    {
-                        std::cerr << "Failed to set client socket non-blocking" << std::endl;
-                        close(cfd);
-                        continue;
-                    }
-                    // response.buildResponse();
-                    // Create client with server context information
-                    Client *cl = new Client(cfd, *this, serverSockets[i].serverIndex, serverSockets[i].port);
-                    _clients[cfd] = cl;
-
-                    DEBUG_PRINT("New connection accepted on server '"
-                                << _servers[serverSockets[i].serverIndex].getServerName()
-                                << "' port " << serverSockets[i].port << " (fd: " << RED << cfd << RESET << ")");
-                }
-            }
+            if (connectionCount(NULL) >= _workerConnections)
+                continue;
+            for (size_t s = 0; s < serverSockets.size(); ++s)
+                acceptLoop.add(serverSockets[s].socket_fd, EventLoop::EV_READ);
+            paused = false;
+            DEBUG_PRINT("Resuming accept");
+            continue;
         }
-
-        // Track clients to close after processing
-        std::vector<int> toClose;
-
-        // Process client I/O or generation steps
-        for (std::map<int, Client *>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+        for (int i = 0; i < ready && !paused; ++i)
         {
-            int cfd = it->first;
-            Client *cl = it->second;
-            ClientState st = cl->getState();
-
-            if (st == GENERATING_RESPONSE)
-            {
-                cl->handleConnection();
-            }
-            else if (st == READING && FD_ISSET(cfd, &read_fds))
+            for (size_t s = 0; s < serverSockets.size(); ++s)
             {
-                cl->handleConnection();
-            }
-            else if (st == WRITING && FD_ISSET(cfd, &write_fds))
-            {
-                cl->handleConnection();
-            }
-            else if (st == CGI_WRITING_INPUT)
-            {
-                int cgi_in = cl->getCgiInputFd();
-                int cgi_out = cl->getCgiOutputFd();
-                // Handle client if we can write more input OR there is output to drain.
-                if ((cgi_in != -1 && FD_ISSET(cgi_in, &write_fds)) ||
-                    (cgi_out != -1 && FD_ISSET(cgi_out, &read_fds)))
+                if (serverSockets[s].socket_fd == acceptLoop.ready(i).fd)
                 {
-                    cl->handleConnection();
+                    paused = !acceptConnections(serverSockets[s], NULL);
+                    break;
                 }
             }
-            else if (st == CGI_READING_OUTPUT)
-            {
-                int cgi_out = cl->getCgiOutputFd();
-                if (cgi_out != -1 && FD_ISSET(cgi_out, &read_fds))
-                    cl->handleConnection();
-            }
-            // Check for CGI timeout
-            if (st == CGI_WRITING_INPUT || st == CGI_READING_OUTPUT)
-            {
-                cl->checkCgiTimeout();
-            }
-
-            // Check for Client timeout (idle connection)
-            if (cl->hasTimedOut())
-            {
-                DEBUG_PRINT(RED << "Client timed out (idle for " << CLIENT_TIMEOUT << "s)" << RESET);
-                // If we are in the middle of something important, we might want to send a 408 Request Timeout
-                // But for simplicity and safety, we'll just close the connection for now.
-                // Ideally, if we are READING, we could send 408.
-                toClose.push_back(cfd);
-            }
-
-            if (cl->getState() == CLOSING)
-            {
-                toClose.push_back(cfd);
-            }
         }
-
-        // Close and delete clients marked for closing
-        for (size_t i = 0; i < toClose.size(); ++i)
+        if (paused)
         {
-            int fd = toClose[i];
-            std::map<int, Client *>::iterator it = _clients.find(fd);
-            if (it != _clients.end())
-            {
-                close(fd);
-                delete it->second;
-                _clients.erase(it);
-            }
+            for (size_t s = 0; s < serverSockets.size(); ++s)
+                acceptLoop.remove(serverSockets[s].socket_fd);
         }
     }
 
-    // Cleanup remaining clients on shutdown
-    for (std::map<int, Client *>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+    // Reactor threads check g_stop after every wakeup
+    g_stop = 1;
+    for (size_t i = 0; i < threads.size(); ++i)
+        _reactors[i]->wakeup();
+    for (size_t i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+    return result;
+}
+
+int HttpServer::runMultiServerAcceptLoop(const std::vector<ServerSocketInfo> &serverSockets)
+{
+    // worker_connections is per process: split the Client pools evenly
+    size_t poolSize = (_workerConnections + _workerThreads - 1) / _workerThreads;
+    bool ready = true;
+    for (size_t i = 0; i < _workerThreads && ready; ++i)
     {
-        close(it->first);
-        delete it->second;
+        _reactors.push_back(new Reactor(*this, i, poolSize));
+        ready = _reactors.back()->init();
     }
-    _clients.clear();
+
+    int result = 1;
+    if (ready && _reactors.size() == 1)
+        result = _reactors[0]->run(serverSockets);
+    else if (ready)
+        result = runThreadedAcceptLoop(serverSockets);
+
+    for (size_t i = 0; i < _reactors.size(); ++i)
+        delete _reactors[i];
+    _reactors.clear();
 
     DEBUG_PRINT("HTTP Server shutting down...");
-    return 0;
+    return result;
 }
@@ -0,0 +1,179 @@
+#include "Common.hpp"
+#include <sys/wait.h>
+
+/* Zero-downtime binary upgrade (kill -USR2 <pid>) and graceful stop (SIGQUIT).
+   - The old process forks and execs its own command line (the new binary on
+     disk) with its listening sockets inherited; WEBSERV_LISTEN_FDS names
+     them, so the new process takes them over instead of binding again and
+     not a single queued connection is lost
+   - Once the new process listens it sends SIGQUIT to the old one
+     (WEBSERV_UPGRADE_PARENT), which stops accepting, finishes its in-flight
+     requests and CGI children, closes idle keep-alive connections and exits
+   - If the new binary fails to start, the old process just keeps serving
+   - worker_processes > 1: the master has no listening sockets of its own
+     (every worker binds a SO_REUSEPORT socket), so the new workers bind
+     fresh sockets next to the old ones. Connections still queued on an old
+     worker's socket when it closes are reset by the kernel.
+*/
+
+#define ENV_LISTEN_FDS "WEBSERV_LISTEN_FDS"
+#define ENV_UPGRADE_PARENT "WEBSERV_UPGRADE_PARENT"
+
+void HttpServer::setCommandLine(int argc, char **argv)
+{
+    _argv.assign(argv, argv + argc);
+}
+
+// Pick up the sockets and the parent pid passed by an upgrading process.
+// The variables are removed so they do not leak into a later upgrade.
+void HttpServer::loadInheritedSockets()
+{
+    const char *fds = std::getenv(ENV_LISTEN_FDS);
+    if (fds != NULL)
+    {
+        std::istringstream iss(fds);
+        std::string item;
+        while (std::getline(iss, item, ';'))
+        {
+            int fd = std::atoi(item.c_str());
+            int type = 0;
+            socklen_t len = sizeof(type);
+            // Only accept descriptors that really are stream sockets
+            if (!item.empty() && fd > STDERR_FILENO &&
+                getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == 0 && type == SOCK_STREAM)
+            {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                _inheritedFds.push_back(fd);
+            }
+        }
+        unsetenv(ENV_LISTEN_FDS);
+        DEBUG_PRINT("Inherited " << _inheritedFds.size() << " listening sockets");
+    }
+
+    const char *parent = std::getenv(ENV_UPGRADE_PARENT);
+    if (parent != NULL)
+    {
+        _upgradeParent = static_cast<pid_t>(std::atol(parent));
+        unsetenv(ENV_UPGRADE_PARENT);
+    }
+}
+
+// Return (and forget) the inherited socket bound to host:port, -1 if none
+int HttpServer::takeInheritedSocket(int port, in_addr_t host)
+{
+    for (size_t i = 0; i < _inheritedFds.size(); ++i)
+    {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        if (getsockname(_inheritedFds[i], (struct sockaddr *)&addr, &len) != 0 || addr.sin_family != AF_INET)
+            continue;
+        if (ntohs(addr.sin_port) == port && addr.sin_addr.s_addr == host)
+        {
+            int fd = _inheritedFds[i];
+            _inheritedFds.erase(_inheritedFds.begin() + i);
+            return fd;
+        }
+    }
+    return -1;
+}
+
+// Sockets for addresses that are no longer in the configuration
+void HttpServer::closeInheritedSockets()
+{
+    for (size_t i = 0; i < _inheritedFds.size(); ++i)
+        close(_inheritedFds[i]);
+    _inheritedFds.clear();
+}
+
+// Tell the process we were upgraded from that we are listening now
+void HttpServer::notifyUpgradeParent()
+{
+    if (_upgradeParent <= 0)
+        return;
+    std::cout << "Upgrade complete, asking old process " << _upgradeParent << " to finish" << std::endl;
+    kill(_upgradeParent, SIGQUIT);
+    _upgradeParent = 0;
+}
+
+// Start the new binary. Returns false if it could not even be forked; a new
+// binary that fails later simply never sends its SIGQUIT.
+bool HttpServer::spawnUpgrade()
+{
+    if (_argv.empty())
+        return false;
+
+    // Everything the child needs is prepared before fork(): with reactor
+    // threads only async-signal-safe calls are allowed in between
+    std::ostringstream fds;
+    for (size_t i = 0; i < _serverSockets.size(); ++i)
+    {
+        if (_serverSockets[i].socket_fd >= 0)
+            fds << _serverSockets[i].socket_fd << ";";
+    }
+    std::ostringstream parent;
+    parent << getpid();
+    std::string fdsEnv = std::string(ENV_LISTEN_FDS) + "=" + fds.str();
+    std::string parentEnv = std::string(ENV_UPGRADE_PARENT) + "=" + parent.str();
+
+    std::vector<char *> env;
+    for (char **e = environ; *e != NULL; ++e)
+    {
+        if (std::strncmp(*e, ENV_LISTEN_FDS "=", sizeof(ENV_LISTEN_FDS)) != 0 &&
+            std::strncmp(*e, ENV_UPGRADE_PARENT "=", sizeof(ENV_UPGRADE_PARENT)) != 0)
+            env.push_back(*e);
+    }
+    env.push_back(const_cast<char *>(fdsEnv.c_str()));
+    env.push_back(const_cast<char *>(parentEnv.c_str()));
+    env.push_back(NULL);
+
+    std::vector<char *> args;
+    for (size_t i = 0; i < _argv.size(); ++i)
+        args.push_back(const_cast<char *>(_argv[i].c_str()));
+    args.push_back(NULL);
+
+    std::cout << "Binary upgrade: starting " << _argv[0] << std::endl;
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "Binary upgrade: fork() failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (pid == 0)
+    {
+        // Fork once more so the new server is not our child: it outlives us
+        // and nobody has to reap it here
+        if (fork() != 0)
+            _exit(0);
+        setsid();
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, NULL); // reactor threads block some
+        for (size_t i = 0; i < _serverSockets.size(); ++i)
+        {
+            if (_serverSockets[i].socket_fd >= 0)
+                fcntl(_serverSockets[i].socket_fd, F_SETFD, 0); // keep across exec
+        }
+        if (std::strchr(args[0], '/') != NULL)
+            execve(args[0], &args[0], &env[0]);
+        else
+        {
+            environ = &env[0];
+            execvp(args[0], &args[0]);
+        }
+        _exit(127);
+    }
+    waitpid(pid, NULL, 0);
+    return true;
+}
+
+// Stop accepting for good (graceful stop). The owner of the event loop must
+// have removed the sockets from it already.
+void HttpServer::stopListening()
+{
+    for (size_t i = 0; i < _serverSockets.size(); ++i)
+    {
+        if (_serverSockets[i].socket_fd >= 0)
+            close(_serverSockets[i].socket_fd);
+        _serverSockets[i].socket_fd = -1;
+    }
+}
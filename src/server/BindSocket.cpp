@@ -1,4 +1,5 @@
 #include "Common.hpp"
+#include <netinet/tcp.h> // TCP_DEFER_ACCEPT, TCP_FASTOPEN
 
 static int createSocket()
 {
@@ -13,6 +14,8 @@ static int createSocket()
         std::cerr << "socket() failed" << std::endl;
         return -1;
     }
+    // CGI children must not inherit it; a binary upgrade clears the flag
+    fcntl(server_fd, F_SETFD, FD_CLOEXEC);
 
     return server_fd;
 }
@@ -34,6 +37,21 @@ static bool setSocketReusable(int server_fd)
     return setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == 0;
 }
 
+/* SO_REUSEPORT lets several sockets (one per worker process) bind the very
+   same host:port. The kernel then load-balances incoming connections across
+   all of them, so each worker accepts from its own queue instead of all
+   workers racing on one shared listening socket. */
+static bool setSocketReusePort(int server_fd)
+{
+#ifdef SO_REUSEPORT
+    int opt = 1;
+    return setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == 0;
+#else
+    (void)server_fd;
+    return false;
+#endif
+}
+
 // Initializes the socket address structure with the specified host and port.
 static void initializeAddress(struct sockaddr_in *addr, int port, in_addr_t host)
 {
@@ -83,9 +101,45 @@ static bool bindSocket(int server_fd, int port, in_addr_t host)
     return true;
 }
 
-static bool startListening(int server_fd)
+/* TCP_DEFER_ACCEPT ("deferred"): the kernel completes the handshake but only
+   reports the connection once the client has sent data, so the server never
+   wakes up for connections that are still silent. The value is a timeout in
+   seconds after which the connection is handed over anyway.
+   TCP_FASTOPEN ("fastopen=N"): a returning client may send its request in
+   the SYN; N bounds the pending fast-open requests. Both are Linux options
+   and are ignored elsewhere. */
+static bool setTcpListenOptions(int server_fd, const ListenOptions &opts)
 {
-    if (listen(server_fd, 128) < 0)
+#ifdef TCP_DEFER_ACCEPT
+    if (opts.deferred)
+    {
+        int secs = LISTEN_DEFER_ACCEPT_SECS;
+        if (setsockopt(server_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &secs, sizeof(secs)) != 0)
+        {
+            std::cerr << "Failed to set TCP_DEFER_ACCEPT: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+#endif
+#ifdef TCP_FASTOPEN
+    if (opts.fastopen > 0)
+    {
+        int qlen = opts.fastopen;
+        if (setsockopt(server_fd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)) != 0)
+        {
+            std::cerr << "Failed to set TCP_FASTOPEN: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+#endif
+    (void)server_fd;
+    (void)opts;
+    return true;
+}
+
+static bool startListening(int server_fd, int backlog)
+{
+    if (listen(server_fd, backlog) < 0)
     {
         std::cerr << "listen() failed" << std::endl;
         return false;
@@ -116,7 +170,7 @@ bool HttpServer::setNonBlocking(int fd)
 }
 
 // Configures the socket for reuse and binds it to the specified host and port.
-static bool configureSocket(int server_fd, int port, in_addr_t host)
+static bool configureSocket(int server_fd, int port, in_addr_t host, bool reusePort, const ListenOptions &opts)
 {
     if (!setSocketReusable(server_fd))
     {
@@ -124,12 +178,21 @@ static bool configureSocket(int server_fd, int port, in_addr_t host)
         return false;
     }
 
+    if (reusePort && !setSocketReusePort(server_fd))
+    {
+        std::cerr << "Failed to set SO_REUSEPORT" << std::endl;
+        return false;
+    }
+
     if (!bindSocket(server_fd, port, host))
     {
         return false;
     }
 
-    if (!startListening(server_fd))
+    if (!setTcpListenOptions(server_fd, opts))
+        return false;
+
+    if (!startListening(server_fd, opts.backlog))
         return false;
 
     if (!HttpServer::setNonBlocking(server_fd))
@@ -142,7 +205,9 @@ static bool configureSocket(int server_fd, int port, in_addr_t host)
 }
 
 // Creates and binds a socket to the specified host and port.
-int HttpServer::createAndBindSocket(int port, in_addr_t host)
+// reusePort is set in worker mode, where every worker binds its own socket,
+// or by the reuseport listen parameter.
+int HttpServer::createAndBindSocket(int port, in_addr_t host, bool reusePort, const ListenOptions &opts)
 {
     int server_fd = createSocket();
     if (server_fd < 0)
@@ -150,11 +215,61 @@ int HttpServer::createAndBindSocket(int port, in_addr_t host)
         return -1;
     }
 
-    if (!configureSocket(server_fd, port, host))
+    if (!configureSocket(server_fd, port, host, reusePort || opts.reuseport, opts))
     {
         close(server_fd);
         return -1;
     }
 
     return server_fd;
-}
\ No newline at end of file
+}
+
+// Read a sysctl that holds a single integer, -1 if unavailable
+static long readSysctl(const char *path)
+{
+    std::ifstream in(path);
+    long value = -1;
+    if (!(in >> value))
+        return -1;
+    return value;
+}
+
+// The values the kernel actually applied to a listening socket, for the
+// startup log: the backlog is silently capped by net.core.somaxconn and
+// TCP_DEFER_ACCEPT is rounded to a retransmission step.
+std::string HttpServer::describeListenSocket(int server_fd, const ListenOptions &opts)
+{
+    std::ostringstream oss;
+    long somaxconn = readSysctl("/proc/sys/net/core/somaxconn");
+    long backlog = opts.backlog;
+    if (somaxconn > 0 && somaxconn < backlog)
+        backlog = somaxconn;
+    oss << "backlog " << backlog;
+    if (somaxconn > 0 && somaxconn < opts.backlog)
+        oss << " (" << opts.backlog << " capped by net.core.somaxconn)";
+
+    int value = 0;
+    socklen_t len = sizeof(value);
+#ifdef TCP_DEFER_ACCEPT
+    if (getsockopt(server_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &value, &len) == 0 && value > 0)
+        oss << ", deferred " << value << "s";
+#endif
+#ifdef TCP_FASTOPEN
+    len = sizeof(value);
+    if (opts.fastopen > 0 && getsockopt(server_fd, IPPROTO_TCP, TCP_FASTOPEN, &value, &len) == 0)
+    {
+        oss << ", fastopen " << value;
+        // Bit 2 of net.ipv4.tcp_fastopen enables the server side
+        long mode = readSysctl("/proc/sys/net/ipv4/tcp_fastopen");
+        if (mode >= 0 && !(mode & 2))
+            oss << " (server side disabled by net.ipv4.tcp_fastopen=" << mode << ")";
+    }
+#endif
+#ifdef SO_REUSEPORT
+    len = sizeof(value);
+    if (getsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &value, &len) == 0 && value)
+        oss << ", reuseport";
+#endif
+    (void)len;
+    return oss.str();
+}
@@ -0,0 +1,42 @@
+#include "ConnectionTable.hpp"
+
+ConnectionTable::ConnectionTable() {}
+
+void ConnectionTable::reserve(size_t fdCount)
+{
+    if (_slots.size() < fdCount)
+        _slots.resize(fdCount);
+    _active.reserve(fdCount);
+}
+
+void ConnectionTable::insert(int fd, Client *cl)
+{
+    if (static_cast<size_t>(fd) >= _slots.size())
+    {
+        // Grow geometrically so a rising fd does not resize on every accept
+        size_t n = _slots.empty() ? 64 : _slots.size();
+        while (n <= static_cast<size_t>(fd))
+            n *= 2;
+        _slots.resize(n);
+    }
+    _slots[fd].client = cl;
+    _slots[fd].pos = _active.size();
+    _active.push_back(fd);
+}
+
+Client *ConnectionTable::erase(int fd)
+{
+    Client *cl = find(fd);
+    if (cl == NULL)
+        return NULL;
+
+    // Swap-remove: the last live fd takes over the freed position
+    size_t pos = _slots[fd].pos;
+    int last = _active.back();
+    _active[pos] = last;
+    _slots[last].pos = pos;
+    _active.pop_back();
+
+    _slots[fd] = Slot();
+    return cl;
+}
@@ -0,0 +1,107 @@
+#include "ContentCache.hpp"
+
+ContentCache::ContentCache() : _budget(0), _bytes(0), _hits(0), _misses(0), _evictions(0)
+{
+    _lru._prev = _lru._next = &_lru;
+}
+
+ContentCache::~ContentCache()
+{
+    while (_lru._next != &_lru)
+        remove(_lru._next);
+}
+
+void ContentCache::configure(size_t budget)
+{
+    _budget = budget;
+    while (_bytes > _budget)
+        remove(_lru._prev);
+}
+
+ContentCache::Entry *ContentCache::acquire(const std::string &key, const OpenFileCache::File &file)
+{
+    if (_budget == 0)
+        return NULL;
+    Map::iterator it = _entries.find(key);
+    if (it == _entries.end())
+    {
+        ++_misses;
+        return NULL;
+    }
+    Entry *e = it->second;
+    const OpenFileCache::File &was = e->_file;
+    if (was.dev != file.dev || was.ino != file.ino || was.size != file.size || was.mtime != file.mtime)
+    {
+        ++_misses;
+        remove(e); // built from an older version of the file
+        return NULL;
+    }
+    ++_hits;
+    unlink(e);
+    linkFront(e);
+    ++e->_refs;
+    return e;
+}
+
+ContentCache::Entry *ContentCache::insert(const std::string &key, const OpenFileCache::File &file,
+                                          std::string &response, size_t headerLen)
+{
+    size_t c = cost(key, response);
+    if (_budget == 0 || c > _budget / 2) // one response must not flush the whole cache
+        return NULL;
+
+    Map::iterator it = _entries.find(key);
+    if (it != _entries.end())
+        remove(it->second);
+    while (_bytes + c > _budget)
+    {
+        remove(_lru._prev);
+        ++_evictions;
+    }
+
+    Entry *e = new Entry();
+    e->_data.swap(response);
+    e->_headerLen = headerLen;
+    e->_file = file;
+    e->_refs = 2; // the cache's and the caller's
+    e->_pos = _entries.insert(std::make_pair(key, e)).first;
+    linkFront(e);
+    _bytes += c;
+    return e;
+}
+
+void ContentCache::release(Entry *e)
+{
+    if (--e->_refs == 0)
+        delete e;
+}
+
+// What an entry holds on to, roughly: the response, the key (map node and
+// entry included) counted once more for the bookkeeping around it
+size_t ContentCache::cost(const std::string &key, const std::string &data)
+{
+    return data.size() + 2 * key.size() + sizeof(Entry);
+}
+
+void ContentCache::linkFront(Entry *e)
+{
+    e->_prev = &_lru;
+    e->_next = _lru._next;
+    _lru._next->_prev = e;
+    _lru._next = e;
+}
+
+void ContentCache::unlink(Entry *e)
+{
+    e->_prev->_next = e->_next;
+    e->_next->_prev = e->_prev;
+}
+
+// Take e out of the cache; a response still being sent keeps it alive
+void ContentCache::remove(Entry *e)
+{
+    unlink(e);
+    _bytes -= cost(e->_pos->first, e->_data);
+    _entries.erase(e->_pos);
+    release(e);
+}
@@ -0,0 +1,188 @@
+#include "EventLoop.hpp"
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/select.h>
+#include <sys/time.h>
+
+#ifdef WEBSERV_USE_EPOLL
+
+// Initial size of the buffer handed to epoll_wait(); it doubles whenever a
+// wakeup fills it completely.
+#define EPOLL_INITIAL_EVENTS 256
+
+EventLoop::EventLoop() : _epfd(-1), _epollEvents(EPOLL_INITIAL_EVENTS) {}
+
+EventLoop::~EventLoop()
+{
+    if (_epfd != -1)
+        close(_epfd);
+}
+
+bool EventLoop::init()
+{
+    if (_epfd != -1)
+        return true;
+    _epfd = epoll_create(EPOLL_INITIAL_EVENTS); // size hint is ignored by modern kernels
+    if (_epfd == -1)
+        return false;
+    // The epoll instance must not leak into CGI children
+    fcntl(_epfd, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+static uint32_t toEpollMask(int events)
+{
+    uint32_t mask = 0;
+    if (events & EventLoop::EV_READ)
+        mask |= EPOLLIN;
+    if (events & EventLoop::EV_WRITE)
+        mask |= EPOLLOUT;
+    return mask;
+}
+
+bool EventLoop::add(int fd, int events)
+{
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = toEpollMask(events);
+    ev.data.fd = fd;
+    return epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool EventLoop::modify(int fd, int events)
+{
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = toEpollMask(events);
+    ev.data.fd = fd;
+    return epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd)
+{
+    // Pre-2.6.9 kernels require a non-NULL event pointer for DEL
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+int EventLoop::wait(int timeoutMs)
+{
+    _ready.clear();
+    int n = epoll_wait(_epfd, &_epollEvents[0], static_cast<int>(_epollEvents.size()), timeoutMs);
+    if (n <= 0)
+        return n;
+
+    for (int i = 0; i < n; ++i)
+    {
+        Event e;
+        e.fd = _epollEvents[i].data.fd;
+        e.events = EV_NONE;
+        if (_epollEvents[i].events & EPOLLIN)
+            e.events |= EV_READ;
+        if (_epollEvents[i].events & EPOLLOUT)
+            e.events |= EV_WRITE;
+        // Errors and hangups wake up whichever side the owner is waiting on
+        if (_epollEvents[i].events & (EPOLLERR | EPOLLHUP))
+            e.events |= EV_READ | EV_WRITE;
+        _ready.push_back(e);
+    }
+    if (static_cast<size_t>(n) == _epollEvents.size())
+        _epollEvents.resize(_epollEvents.size() * 2);
+    return n;
+}
+
+const char *EventLoop::backendName() const
+{
+    return "epoll";
+}
+
+#else // select() fallback
+
+EventLoop::EventLoop() {}
+
+EventLoop::~EventLoop() {}
+
+bool EventLoop::init()
+{
+    return true;
+}
+
+bool EventLoop::add(int fd, int events)
+{
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return false;
+    _interest[fd] = events;
+    return true;
+}
+
+bool EventLoop::modify(int fd, int events)
+{
+    std::map<int, int>::iterator it = _interest.find(fd);
+    if (it == _interest.end())
+        return false;
+    it->second = events;
+    return true;
+}
+
+void EventLoop::remove(int fd)
+{
+    _interest.erase(fd);
+}
+
+int EventLoop::wait(int timeoutMs)
+{
+    _ready.clear();
+
+    fd_set read_fds;
+    fd_set write_fds;
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    int max_fd = -1;
+
+    for (std::map<int, int>::const_iterator it = _interest.begin(); it != _interest.end(); ++it)
+    {
+        if (it->second & EV_READ)
+            FD_SET(it->first, &read_fds);
+        if (it->second & EV_WRITE)
+            FD_SET(it->first, &write_fds);
+        if (it->second != EV_NONE && it->first > max_fd)
+            max_fd = it->first;
+    }
+
+    struct timeval tv;
+    struct timeval *tvp = NULL;
+    if (timeoutMs >= 0)
+    {
+        tv.tv_sec = timeoutMs / 1000;
+        tv.tv_usec = (timeoutMs % 1000) * 1000;
+        tvp = &tv;
+    }
+
+    int n = select(max_fd + 1, &read_fds, &write_fds, NULL, tvp);
+    if (n <= 0)
+        return n;
+
+    for (std::map<int, int>::const_iterator it = _interest.begin(); it != _interest.end(); ++it)
+    {
+        Event e;
+        e.fd = it->first;
+        e.events = EV_NONE;
+        if (FD_ISSET(it->first, &read_fds))
+            e.events |= EV_READ;
+        if (FD_ISSET(it->first, &write_fds))
+            e.events |= EV_WRITE;
+        if (e.events != EV_NONE)
+            _ready.push_back(e);
+    }
+    return static_cast<int>(_ready.size());
+}
+
+const char *EventLoop::backendName() const
+{
+    return "select";
+}
+
+#endif
@@ -12,26 +12,31 @@
 
 #include "Common.hpp"
 
-HttpServer::HttpServer(ConfigParser &configParser) : _currentLocation(NULL), _configParser(configParser)
+HttpServer::HttpServer(const ConfigParser &configParser)
+    : _nextReactor(0),
+      _workerProcesses(configParser.getWorkerProcesses()),
+      _workerThreads(configParser.getWorkerThreads()),
+      _workerConnections(configParser.getWorkerConnections()),
+      _upgradeParent(0),
+      _configParser(configParser)
 {
     _servers = configParser.getServers();
     _root = configParser.getRoot();
     _index = configParser.getIndex();
-    if (!_servers.empty()) 
-        mapCurrentLocationConfig("/", 0); // default location
 }
 
 HttpServer::~HttpServer() {}
 
-// Map the current location config based on the request path
-void HttpServer::mapCurrentLocationConfig(const std::string &path, const int serverIndex)
+// Find the location block of a server that matches the request path.
+// Routing results live in the request (HTTPparser), never in the server, so
+// concurrent requests on different threads cannot see each other's route.
+const LocationConfig *HttpServer::findLocation(const std::string &path, const int serverIndex) const
 {
     // Check if the server index is valid
     if (serverIndex < 0 || static_cast<size_t>(serverIndex) >= _servers.size())
     {
-        DEBUG_PRINT(RED << "mapCurrentLocationConfig: invalid server index " << serverIndex << RESET);
-        _currentLocation = NULL;
-        return;
+        DEBUG_PRINT(RED << "findLocation: invalid server index " << serverIndex << RESET);
+        return NULL;
     }
 
     const std::map<std::string, LocationConfig> &locations = _servers[serverIndex].getLocations();
@@ -46,7 +51,7 @@ void HttpServer::mapCurrentLocationConfig(const std::string &path, const int ser
 
         // Check if the request path starts with this location path
         bool matches = (path.size() >= locationPath.size() &&
-                        path.substr(0, locationPath.size()) == locationPath);
+                        path.compare(0, locationPath.size(), locationPath) == 0);
 
         // If this is a longer match than what we've found so far, use it
         if (matches && locationPath.size() > longestMatchLength)
@@ -55,38 +60,39 @@ void HttpServer::mapCurrentLocationConfig(const std::string &path, const int ser
             bestLocation = &it->second;
         }
     }
-    // Set the best matching location, or keep current if no match found
-    if (bestLocation != NULL)
-    {
-        _currentLocation = bestLocation;
-    }
+    return bestLocation;
 }
 
 // Get the full file path based on the request path and
-//    current location config
-std::string HttpServer::getFilePath(const std::string &path, const int serverIndex)
+//    the location config matched for it
+std::string HttpServer::getFilePath(const std::string &path, const int serverIndex, const LocationConfig *loc) const
 {
     std::string filePath;
-    if (_currentLocation->path == path)
+    if (loc == NULL)
+    {
+        // No location block matched: serve straight from the server root
+        filePath = _servers[serverIndex].getRoot() + path;
+    }
+    else if (loc->path == path)
     {
-        if (!_currentLocation->root.empty())
+        if (!loc->root.empty())
         {
-            if (!_currentLocation->index.empty())
+            if (!loc->index.empty())
             {
-                filePath = _currentLocation->root + path + _currentLocation->index;
+                filePath = loc->root + path + loc->index;
             }
-            else if (_currentLocation->autoindex)
-                filePath = _currentLocation->root + path;
+            else if (loc->autoindex)
+                filePath = loc->root + path;
             else
             {
-                filePath = _currentLocation->root + path + _servers[serverIndex].getIndex(); // fallback to server index
+                filePath = loc->root + path + _servers[serverIndex].getIndex(); // fallback to server index
             }
         }
         else
         {
-            if (!_currentLocation->index.empty())
-                filePath = _servers[serverIndex].getRoot() + path + _currentLocation->index;
-            else if (_currentLocation->autoindex)
+            if (!loc->index.empty())
+                filePath = _servers[serverIndex].getRoot() + path + loc->index;
+            else if (loc->autoindex)
                 filePath = _servers[serverIndex].getRoot() + path;
             else
                 filePath = _servers[serverIndex].getRoot() + path + _servers[serverIndex].getIndex(); // fallback to server index
@@ -94,24 +100,22 @@ std::string HttpServer::getFilePath(const std::string &path, const int serverInd
     }
     else
     {
-        (!_currentLocation->root.empty()) ? filePath = _currentLocation->root + path
-                                          : filePath = _servers[serverIndex].getRoot() + path;
+        (!loc->root.empty()) ? filePath = loc->root + path
+                             : filePath = _servers[serverIndex].getRoot() + path;
     }
 
     return filePath;
 }
 
-// Public helper to resolve file path for a request path and map location
-std::string HttpServer::resolveFilePathFor(const std::string &path, const int serverIndex)
+// Route a parsed request: store the matched location and the resolved
+// filesystem path in the parser and return the path.
+std::string HttpServer::resolveFilePathFor(HTTPparser &request, const int serverIndex) const
 {
-    mapCurrentLocationConfig(path, serverIndex);
-    return getFilePath(path, serverIndex);
-}
-
-// for use in response.cpp return the current location config
-const LocationConfig *HttpServer::getCurrentLocation()
-{
-    return _currentLocation;
+    const LocationConfig *loc = findLocation(request.getPath(), serverIndex);
+    std::string filePath = getFilePath(request.getPath(), serverIndex, loc);
+    request.setCurrentLocation(loc);
+    request.setCurrentFilePath(filePath);
+    return filePath;
 }
 
 int HttpServer::start()
@@ -122,12 +126,26 @@ int HttpServer::start()
         std::cerr << "Validation of Config File failed. Server will not start." << std::endl;
         return 1;
     }
+    setupSignalHandlers();
+    loadInheritedSockets();
+
+    // With worker_processes > 1 this process becomes the master and every
+    // worker binds its own SO_REUSEPORT sockets (see WorkerProcesses.cpp)
+    if (_workerProcesses > 1)
+        return runMaster();
+    return runWorker(0);
+}
 
+// Create a listening socket for every port of every server block.
+// Returns false if not a single socket could be created.
+bool HttpServer::openServerSockets(bool reusePort, bool verbose)
+{
     // Iterate through all server blocks
     for (size_t serverIdx = 0; serverIdx < _servers.size(); ++serverIdx)
     {
         const ServerConfig &serverConfig = _servers[serverIdx];
         const std::vector<int> &ports = serverConfig.getListenPorts();
+        const std::vector<ListenOptions> &options = serverConfig.getListenOptions();
 
         DEBUG_PRINT("Setting up server block " << serverIdx
                                                << " (" << serverConfig.getServerName() << ") with "
@@ -138,11 +156,13 @@ int HttpServer::start()
         {
             int port = ports[portIdx];
 
-            // Temporarily set _port for createAndBindSocket() to use
-            //_port = port;
-
+            // After a binary upgrade the old process's socket is reused, so
+            // connections already queued on it are not lost
+            int server_fd = takeInheritedSocket(port, serverConfig.getHost());
+            bool inherited = (server_fd >= 0);
             // Pass the host address to the socket creation function.
-            int server_fd = createAndBindSocket(port, serverConfig.getHost());
+            if (!inherited)
+                server_fd = createAndBindSocket(port, serverConfig.getHost(), reusePort, options[portIdx]);
             if (server_fd < 0)
             {
                 std::cerr << "Failed to bind server " << serverIdx
@@ -159,6 +179,8 @@ int HttpServer::start()
             }
 
             _serverSockets.push_back(ServerSocketInfo(server_fd, port, serverIdx));
+            if (!verbose)
+                continue;
             // Convert the host address back to a string for logging.
             char hostStr[INET_ADDRSTRLEN];
             struct in_addr host_addr;
@@ -166,26 +188,19 @@ int HttpServer::start()
             inet_ntop(AF_INET, &host_addr, hostStr, INET_ADDRSTRLEN);
             std::cout << "Server block " << serverIdx
                       << " (" << serverConfig.getServerName()
-                      << ") listening on " << hostStr << ":" << port << std::endl;
+                      << ") listening on " << hostStr << ":" << port
+                      << " - " << describeListenSocket(server_fd, options[portIdx])
+                      << (inherited ? ", inherited" : "") << std::endl;
         }
     }
+    closeInheritedSockets();
 
     if (_serverSockets.empty())
     {
         std::cerr << "No sockets could be created for any server block" << std::endl;
-        return 1;
-    }
-    printStartupMessage();
-
-    // Call the aligned accept loop
-    int result = runMultiServerAcceptLoop(_serverSockets);
-
-    // Cleanup
-    for (size_t i = 0; i < _serverSockets.size(); ++i)
-    {
-        close(_serverSockets[i].socket_fd);
+        return false;
     }
-    return result;
+    return true;
 }
 
 // Pre-validation to check all configurations before server startup
@@ -298,7 +313,7 @@ bool HttpServer::validateConfiguration()
 }
 
 
-size_t HttpServer::getServerMaxBodySize(size_t serverIndex)
+size_t HttpServer::getServerMaxBodySize(size_t serverIndex) const
 {
     if (serverIndex < _servers.size())
     {
@@ -306,4 +321,10 @@ size_t HttpServer::getServerMaxBodySize(size_t serverIndex)
     }
     // Return a default value if the server index is invalid
     return 1024 * 1024; // 1 MiB
-}
\ No newline at end of file
+}
+
+// serverIndex always comes from a listening socket, so it is in range
+const ServerConfig &HttpServer::getServerConfig(size_t serverIndex) const
+{
+    return _servers[serverIndex];
+}
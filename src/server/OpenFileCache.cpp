@@ -0,0 +1,176 @@
+#include "OpenFileCache.hpp"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+OpenFileCache::OpenFileCache(const TimerWheel &clock)
+    : _clock(clock), _max(0), _inactiveMs(0), _validMs(0), _cacheErrors(false), _hits(0), _misses(0)
+{
+    _lru.prev = _lru.next = &_lru;
+}
+
+OpenFileCache::~OpenFileCache()
+{
+    while (_lru.next != &_lru)
+        remove(_lru.next);
+    unload(_scratch);
+}
+
+void OpenFileCache::configure(size_t max, uint64_t inactiveMs, uint64_t validMs, bool cacheErrors)
+{
+    _max = max;
+    _inactiveMs = inactiveMs;
+    _validMs = validMs;
+    _cacheErrors = cacheErrors;
+    while (_entries.size() > _max)
+        remove(_lru.prev);
+}
+
+bool OpenFileCache::stat(const std::string &path, File &info)
+{
+    Entry *e = lookup(path);
+    info = e->file;
+    if (e == &_scratch)
+        unload(_scratch);
+    return info.err == 0;
+}
+
+int OpenFileCache::open(const std::string &path, File &info)
+{
+    Entry *e = lookup(path);
+    info = e->file;
+    if (e->fd == -1)
+        return -1;
+    if (e == &_scratch)
+    {
+        // Not cached: hand over the descriptor itself
+        int fd = _scratch.fd;
+        _scratch.fd = -1;
+        return fd;
+    }
+    // sendfile() takes explicit offsets, so sharing the open file is safe;
+    // the copy stays valid when the entry is closed
+    return fcntl(e->fd, F_DUPFD_CLOEXEC, 0);
+}
+
+void OpenFileCache::expire()
+{
+    uint64_t now = _clock.now();
+    while (_lru.prev != &_lru && now - _lru.prev->lastUsed >= _inactiveMs)
+        remove(_lru.prev);
+}
+
+OpenFileCache::Entry *OpenFileCache::lookup(const std::string &path)
+{
+    uint64_t now = _clock.now();
+    if (_max != 0)
+    {
+        Map::iterator it = _entries.find(path);
+        if (it != _entries.end())
+        {
+            Entry *e = it->second;
+            if (now >= e->validUntil && unchanged(path, *e))
+                e->validUntil = now + _validMs;
+            if (now < e->validUntil)
+            {
+                ++_hits;
+                e->lastUsed = now;
+                unlink(e);
+                linkFront(e);
+                return e;
+            }
+            remove(e); // changed on disk: load it again
+        }
+    }
+
+    ++_misses;
+    unload(_scratch);
+    load(path, _scratch);
+    if (_max == 0 || (_scratch.file.err != 0 && !_cacheErrors))
+        return &_scratch;
+
+    Entry *e = new Entry(_scratch);
+    _scratch.fd = -1; // moved to the entry
+    e->validUntil = now + _validMs;
+    e->lastUsed = now;
+    e->pos = _entries.insert(std::make_pair(path, e)).first;
+    linkFront(e);
+    if (_entries.size() > _max)
+        remove(_lru.prev);
+    return e;
+}
+
+// Look path up on disk. Regular files stay open; O_NONBLOCK keeps a FIFO
+// from blocking the loop in open(), O_CLOEXEC keeps CGI children of other
+// threads from inheriting the descriptor even for an instant.
+void OpenFileCache::load(const std::string &path, Entry &e)
+{
+    struct stat st;
+    e.file = File();
+    e.fd = -1;
+    int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1)
+    {
+        e.file.err = errno;
+        // A directory can be searchable without being readable
+        if (errno != EACCES || ::stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+            return;
+        e.file.err = 0;
+    }
+    else if (fstat(fd, &st) != 0)
+    {
+        e.file.err = errno;
+        close(fd);
+        return;
+    }
+    e.file.isDir = S_ISDIR(st.st_mode);
+    e.file.isReg = S_ISREG(st.st_mode);
+    e.file.size = st.st_size;
+    e.file.mtime = st.st_mtime;
+    e.file.dev = st.st_dev;
+    e.file.ino = st.st_ino;
+    if (fd != -1 && e.file.isReg)
+        e.fd = fd;
+    else if (fd != -1)
+        close(fd);
+}
+
+void OpenFileCache::unload(Entry &e)
+{
+    if (e.fd != -1)
+        close(e.fd);
+    e.fd = -1;
+}
+
+// One stat(): does path still name what the entry describes?
+bool OpenFileCache::unchanged(const std::string &path, const Entry &e)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+        return e.file.err == errno;
+    return e.file.err == 0 && st.st_dev == e.file.dev && st.st_ino == e.file.ino && st.st_size == e.file.size &&
+           st.st_mtime == e.file.mtime;
+}
+
+void OpenFileCache::linkFront(Entry *e)
+{
+    e->prev = &_lru;
+    e->next = _lru.next;
+    _lru.next->prev = e;
+    _lru.next = e;
+}
+
+void OpenFileCache::unlink(Entry *e)
+{
+    e->prev->next = e->next;
+    e->next->prev = e->prev;
+}
+
+void OpenFileCache::remove(Entry *e)
+{
+    unlink(e);
+    unload(*e);
+    _entries.erase(e->pos);
+    delete e;
+}
@@ -0,0 +1,472 @@
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Client.hpp"
+
+/* Per-thread event loop.
+   - Listening sockets (single-threaded mode), client sockets, CGI pipes and
+     the wakeup pipe are registered once in the EventLoop
+   - A client's interest mask is only touched when its state changes
+     (see updateClientEvents())
+   - Delegates state transitions to Client::handleConnection()
+*/
+
+Reactor::Reactor(HttpServer &server, size_t id, size_t poolSize)
+    : _server(server), _id(id), _pool(server), _poolSize(poolSize), _statsSeen(g_statsRequest),
+      _upgradeSeen(g_upgradeRequest),
+      _readWakeups(0), _readBytes(0),
+      _loopGeneration(0), _files(_timers), _owned(0)
+{
+    pthread_mutex_init(&_queueLock, NULL);
+    _wakeupPipe[0] = _wakeupPipe[1] = -1;
+}
+
+Reactor::~Reactor()
+{
+    while (!_clients.empty())
+        closeClient(_clients.fdAt(_clients.size() - 1));
+    // Connections that were posted but never adopted
+    for (size_t i = 0; i < _queue.size(); ++i)
+        close(_queue[i].fd);
+    if (_wakeupPipe[0] != -1)
+        close(_wakeupPipe[0]);
+    if (_wakeupPipe[1] != -1)
+        close(_wakeupPipe[1]);
+    pthread_mutex_destroy(&_queueLock);
+}
+
+bool Reactor::init()
+{
+    _pool.reserve(_poolSize);
+    const ConfigParser &config = _server._configParser;
+    _files.configure(config.getOpenFileCacheMax(), config.getOpenFileCacheInactiveMs(),
+                     config.getOpenFileCacheValidMs(), config.getOpenFileCacheErrors());
+    _content.configure(config.getContentCacheSize());
+    // Room for every pooled client plus listeners, pipes and stdio
+    _clients.reserve(_poolSize + 64);
+    if (!_loop.init())
+    {
+        std::cerr << "Failed to initialise " << _loop.backendName() << " event loop" << std::endl;
+        return false;
+    }
+    if (pipe(_wakeupPipe) == -1)
+    {
+        std::cerr << "Failed to create reactor wakeup pipe: " << strerror(errno) << std::endl;
+        return false;
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        fcntl(_wakeupPipe[i], F_SETFD, FD_CLOEXEC);
+        if (!HttpServer::setNonBlocking(_wakeupPipe[i]))
+            return false;
+    }
+    return _loop.add(_wakeupPipe[0], EventLoop::EV_READ);
+}
+
+// Interest of the client socket itself for a given state. While a CGI runs
+// the socket is not watched at all so a peer hangup cannot spin the loop.
+static int socketInterest(ClientState st)
+{
+    if (st == READING)
+        return EventLoop::EV_READ;
+    if (st == WRITING)
+        return EventLoop::EV_WRITE;
+    return EventLoop::EV_NONE;
+}
+
+void Reactor::watchCgiPipe(Client *cl, int fd, int events)
+{
+    if (fd == -1)
+        return;
+    if (!_loop.add(fd, events))
+    {
+        std::cerr << "Failed to register CGI pipe " << fd << " in event loop" << std::endl;
+        return;
+    }
+    if (static_cast<size_t>(fd) >= _cgiPipeOwners.size())
+        _cgiPipeOwners.resize(fd + 64);
+    _cgiPipeOwners[fd] = PipeOwner(cl, _loopGeneration);
+}
+
+Reactor::PipeOwner *Reactor::findPipeOwner(int fd)
+{
+    if (fd < 0 || static_cast<size_t>(fd) >= _cgiPipeOwners.size() || _cgiPipeOwners[fd].client == NULL)
+        return NULL;
+    return &_cgiPipeOwners[fd];
+}
+
+void Reactor::unwatchCgiPipe(int fd)
+{
+    if (fd == -1)
+        return;
+    PipeOwner *owner = findPipeOwner(fd);
+    if (owner == NULL)
+        return;
+    // The client removes and closes a pipe itself once it is done with it
+    // (Client::closeCgiPipe); the DEL below then just fails harmlessly.
+    _loop.remove(fd);
+    *owner = PipeOwner();
+}
+
+// Bring the event loop registration of a client in line with its state.
+// Cheap no-op when the state did not change since the last call.
+void Reactor::updateClientEvents(Client *cl)
+{
+    Client::PollRegistration &reg = cl->getPollRegistration();
+    ClientState st = cl->getState();
+    if (st == reg.state)
+        return;
+
+    int oldMask = socketInterest(reg.state);
+    int newMask = socketInterest(st);
+    int fd = cl->getSocket();
+    if (oldMask == EventLoop::EV_NONE && newMask != EventLoop::EV_NONE)
+    {
+        if (!_loop.add(fd, newMask))
+        {
+            std::cerr << "Failed to register client socket " << fd << " in event loop" << std::endl;
+            cl->getPollRegistration().state = st;
+            return;
+        }
+    }
+    else if (oldMask != EventLoop::EV_NONE && newMask == EventLoop::EV_NONE)
+        _loop.remove(fd);
+    else if (oldMask != newMask)
+        _loop.modify(fd, newMask);
+
+    // CGI pipes are opened and closed together with state transitions, so
+    // re-registering them here keeps the ownership table exact.
+    unwatchCgiPipe(reg.cgiIn);
+    unwatchCgiPipe(reg.cgiOut);
+    reg.cgiIn = -1;
+    reg.cgiOut = -1;
+    if (st == CGI_WRITING_INPUT)
+    {
+        // Also watch CGI stdout so we can drain it while feeding stdin.
+        reg.cgiIn = cl->getCgiInputFd();
+        reg.cgiOut = cl->getCgiOutputFd();
+        watchCgiPipe(cl, reg.cgiIn, EventLoop::EV_WRITE);
+        watchCgiPipe(cl, reg.cgiOut, EventLoop::EV_READ);
+    }
+    else if (st == CGI_READING_OUTPUT)
+    {
+        reg.cgiOut = cl->getCgiOutputFd();
+        watchCgiPipe(cl, reg.cgiOut, EventLoop::EV_READ);
+    }
+    reg.state = st;
+}
+
+// Run the client state machine for a readiness event that matches the state
+// it is waiting in. GENERATING_RESPONSE needs no I/O, so it is driven inline
+// instead of waiting for another loop iteration.
+void Reactor::dispatchClientEvent(Client *cl, int events)
+{
+    ClientState st = cl->getState();
+    bool wanted = (st == READING && (events & EventLoop::EV_READ)) ||
+                  (st == WRITING && (events & EventLoop::EV_WRITE)) ||
+                  st == CGI_WRITING_INPUT || st == CGI_READING_OUTPUT;
+    if (!wanted)
+        return;
+
+    cl->handleConnection();
+    if (st == READING)
+    {
+        size_t n = cl->takeBytesRead();
+        if (n > 0)
+        {
+            ++_readWakeups;
+            _readBytes += n;
+        }
+    }
+    while (cl->getState() == GENERATING_RESPONSE)
+        cl->handleConnection();
+    updateClientEvents(cl);
+}
+
+void Reactor::closeClient(int fd)
+{
+    Client *cl = _clients.erase(fd);
+    if (cl == NULL)
+        return;
+
+    Client::PollRegistration &reg = cl->getPollRegistration();
+    if (socketInterest(reg.state) != EventLoop::EV_NONE)
+        _loop.remove(fd);
+    unwatchCgiPipe(reg.cgiIn);
+    unwatchCgiPipe(reg.cgiOut);
+
+    close(fd);
+    _pool.release(cl);
+    updateOwned();
+}
+
+void Reactor::adopt(int fd, const HttpServer::ServerSocketInfo &info)
+{
+    // Create client with server context information
+    Client *cl = _pool.acquire(fd, info.serverIndex, info.port);
+    cl->setEventLoop(&_loop);
+    cl->setTimerWheel(&_timers);
+    cl->setFileCache(&_files);
+    cl->setContentCache(&_content);
+    cl->armTimer();
+    _clients.insert(fd, cl);
+    updateOwned();
+    updateClientEvents(cl);
+    if (cl->getPollRegistration().state != READING)
+    {
+        // Could not be registered (e.g. select() and fd >= FD_SETSIZE)
+        closeClient(fd);
+        return;
+    }
+    DEBUG_PRINT("Reactor " << _id << " adopted connection on port " << info.port
+                           << " (fd: " << RED << fd << RESET << ")");
+}
+
+// Answer to SIGUSR1 (see handle_stats_signal())
+void Reactor::dumpStats()
+{
+    _statsSeen = g_statsRequest;
+    unsigned long hits = _files.hits();
+    unsigned long misses = _files.misses();
+    std::ostringstream oss;
+    oss << "[pid " << getpid() << " reactor " << _id << "] connections: " << _clients.size()
+        << ", client pool: capacity " << _pool.capacity() << ", free " << _pool.available()
+        << ", hits " << _pool.hits() << ", misses " << _pool.misses()
+        << ", reads: " << _readBytes << " bytes in " << _readWakeups << " wakeups ("
+        << (_readWakeups ? _readBytes / _readWakeups : 0) << " bytes/wakeup)"
+        << ", open file cache: " << _files.size() << " entries, hits " << hits
+        << ", misses " << misses << " (" << (hits + misses ? hits * 100 / (hits + misses) : 0) << "% hits)"
+        << ", content cache: " << _content.size() << " entries, " << _content.bytes() << " bytes, hits "
+        << _content.hits() << ", misses " << _content.misses() << ", evictions " << _content.evictions() << "\n";
+    // One write per line so reports of concurrent reactors do not interleave
+    std::cerr << oss.str() << std::flush;
+}
+
+void Reactor::updateOwned()
+{
+    pthread_mutex_lock(&_queueLock);
+    _owned = _clients.size();
+    pthread_mutex_unlock(&_queueLock);
+}
+
+size_t Reactor::load()
+{
+    pthread_mutex_lock(&_queueLock);
+    size_t n = _owned + _queue.size();
+    pthread_mutex_unlock(&_queueLock);
+    return n;
+}
+
+void Reactor::post(int fd, const HttpServer::ServerSocketInfo &info)
+{
+    pthread_mutex_lock(&_queueLock);
+    _queue.push_back(Handoff(fd, info));
+    // One pending byte is enough: the reactor drains the pipe before it
+    // takes the queue, so later posts ride on the same wakeup.
+    bool first = (_queue.size() == 1);
+    pthread_mutex_unlock(&_queueLock);
+    if (first)
+        wakeup();
+}
+
+void Reactor::wakeup()
+{
+    char c = 1;
+    // EAGAIN means a wakeup is already pending, which is just as good
+    if (write(_wakeupPipe[1], &c, 1) < 0 && errno != EAGAIN)
+        std::cerr << "Failed to wake up reactor " << _id << std::endl;
+}
+
+void Reactor::drainWakeupPipe()
+{
+    char buf[64];
+    while (read(_wakeupPipe[0], buf, sizeof(buf)) > 0)
+        ;
+}
+
+void Reactor::adoptQueued()
+{
+    std::vector<Handoff> pending;
+    pthread_mutex_lock(&_queueLock);
+    pending.swap(_queue);
+    pthread_mutex_unlock(&_queueLock);
+    for (size_t i = 0; i < pending.size(); ++i)
+        adopt(pending[i].fd, pending[i].info);
+}
+
+// Only clients whose timer is due are touched, so a wakeup costs
+// O(expired timers) no matter how many connections are open.
+void Reactor::expireTimers(std::vector<int> &toClose)
+{
+    _expired.clear();
+    _timers.expire(_expired);
+    for (size_t i = 0; i < _expired.size(); ++i)
+    {
+        Client *cl = static_cast<Client *>(_expired[i]->data);
+        cl->handleTimeout(); // CGI: 504 and WRITING, otherwise CLOSING
+        while (cl->getState() == GENERATING_RESPONSE)
+            cl->handleConnection(); // pipelined requests behind the 504
+        updateClientEvents(cl);
+        if (cl->getState() == CLOSING)
+            toClose.push_back(cl->getSocket());
+    }
+}
+
+// Graceful stop: connections that are not in the middle of a request are
+// closed, the others run to completion
+void Reactor::collectIdleClients(std::vector<int> &toClose)
+{
+    for (size_t i = 0; i < _clients.size(); ++i)
+    {
+        if (_clients.clientAt(i)->isIdle())
+            toClose.push_back(_clients.fdAt(i));
+    }
+}
+
+int Reactor::run(const std::vector<HttpServer::ServerSocketInfo> &listeners)
+{
+    for (size_t i = 0; i < listeners.size(); ++i)
+    {
+        if (!_loop.add(listeners[i].socket_fd, EventLoop::EV_READ))
+        {
+            std::cerr << "Failed to register server socket " << listeners[i].socket_fd << std::endl;
+            return 1;
+        }
+    }
+    DEBUG_PRINT("Reactor " << _id << " running, event loop backend: " << _loop.backendName());
+
+    std::vector<int> toClose;
+    std::vector<size_t> readyListeners;
+    // While paused (worker_connections reached or out of fds) the listeners
+    // leave the loop; accepting resumes once a connection closed or after
+    // ACCEPT_RESUME_POLL_MS, whichever comes first
+    bool paused = false;
+    uint64_t pausedAt = 0;
+    bool draining = false; // SIGQUIT received
+
+    while (!g_stop)
+    {
+        // Sleep until the next timer is due; at most 1s to honor shutdown
+        int ready = _loop.wait(_timers.nextTimeoutMs(paused ? ACCEPT_RESUME_POLL_MS : 1000));
+        _timers.updateClock();
+        if (ready < 0)
+        {
+            if (errno != EINTR)
+            {
+                std::cerr << "event loop wait() failed" << std::endl;
+                break;
+            }
+            ready = 0; // Interrupted by signal: the flags below are checked at once
+        }
+        ++_loopGeneration;
+
+        toClose.clear();
+        readyListeners.clear();
+        bool woken = false;
+        for (int i = 0; i < ready; ++i)
+        {
+            const EventLoop::Event &ev = _loop.ready(i);
+
+            Client *cl = _clients.find(ev.fd);
+            if (cl != NULL)
+            {
+                dispatchClientEvent(cl, ev.events);
+                if (cl->getState() == CLOSING)
+                    toClose.push_back(ev.fd);
+                continue;
+            }
+
+            PipeOwner *owner = findPipeOwner(ev.fd);
+            if (owner != NULL)
+            {
+                // Skip stale events for a pipe fd number that was reused by a
+                // pipe registered after this batch was collected.
+                if (owner->generation == _loopGeneration)
+                    continue;
+                cl = owner->client;
+                dispatchClientEvent(cl, ev.events);
+                if (cl->getState() == CLOSING)
+                    toClose.push_back(cl->getSocket());
+                continue;
+            }
+
+            if (ev.fd == _wakeupPipe[0])
+            {
+                woken = true;
+                continue;
+            }
+
+            for (size_t s = 0; s < listeners.size(); ++s)
+            {
+                if (listeners[s].socket_fd == ev.fd)
+                {
+                    readyListeners.push_back(s);
+                    break;
+                }
+            }
+        }
+
+        expireTimers(toClose);
+        _files.expire();
+        if (_statsSeen != g_statsRequest)
+            dumpStats();
+
+        if (!listeners.empty() && _upgradeSeen != g_upgradeRequest)
+        {
+            _upgradeSeen = g_upgradeRequest;
+            if (!draining)
+                _server.spawnUpgrade();
+        }
+        if (g_graceful && !draining)
+        {
+            // Leave the loop first: after an upgrade the new process shares
+            // these sockets, and epoll would keep reporting them otherwise
+            for (size_t s = 0; s < listeners.size() && !paused; ++s)
+                _loop.remove(listeners[s].socket_fd);
+            if (!listeners.empty())
+                _server.stopListening();
+            draining = true;
+            readyListeners.clear();
+            DEBUG_PRINT("Reactor " << _id << " draining " << _clients.size() << " connections");
+        }
+        if (draining)
+            collectIdleClients(toClose);
+
+        // Close and delete clients marked for closing
+        for (size_t i = 0; i < toClose.size(); ++i)
+            closeClient(toClose[i]);
+        if (draining && !listeners.empty() && _clients.empty())
+            break;
+
+        // Adopt and accept last, so fds reused by new connections never see
+        // stale readiness from this batch.
+        if (woken)
+        {
+            drainWakeupPipe();
+            adoptQueued();
+        }
+        if (paused && !draining && _clients.size() < _server.getWorkerConnections() &&
+            (!toClose.empty() || _timers.now() - pausedAt >= ACCEPT_RESUME_POLL_MS))
+        {
+            for (size_t s = 0; s < listeners.size(); ++s)
+                _loop.add(listeners[s].socket_fd, EventLoop::EV_READ);
+            paused = false;
+            DEBUG_PRINT("Reactor " << _id << " resuming accept");
+        }
+        for (size_t i = 0; i < readyListeners.size() && !paused; ++i)
+        {
+            if (_server.acceptConnections(listeners[readyListeners[i]], this))
+                continue;
+            for (size_t s = 0; s < listeners.size(); ++s)
+                _loop.remove(listeners[s].socket_fd);
+            paused = true;
+            pausedAt = _timers.now();
+        }
+    }
+
+    // Cleanup remaining clients on shutdown
+    while (!_clients.empty())
+        closeClient(_clients.fdAt(_clients.size() - 1));
+
+    DEBUG_PRINT("Reactor " << _id << " shutting down...");
+    return 0;
+}
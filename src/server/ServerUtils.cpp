@@ -3,16 +3,59 @@
 // Global stop flag set by signal handlers
 volatile sig_atomic_t g_stop = 0;
 
+volatile sig_atomic_t g_statsRequest = 0;
+
+volatile sig_atomic_t g_upgradeRequest = 0;
+
+volatile sig_atomic_t g_graceful = 0;
+
 void handle_stop_signal(int)
 {
     g_stop = 1;
 }
 
-// Helper to set a socket to non-blocking mode
+void handle_stats_signal(int)
+{
+    ++g_statsRequest;
+}
+
+void handle_upgrade_signal(int)
+{
+    ++g_upgradeRequest;
+}
+
+void handle_graceful_signal(int)
+{
+    g_graceful = 1;
+}
+
+// Install the stop handlers. SA_RESTART is left out on purpose so blocking
+// calls (the master's waitpid(), the event loop wait) return EINTR and notice
+// g_stop right away.
 void HttpServer::setupSignalHandlers()
 {
-    std::signal(SIGINT, handle_stop_signal);
-    std::signal(SIGTERM, handle_stop_signal);
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // kill -USR1 <pid>: print connection and Client pool counters to stderr
+    sa.sa_handler = handle_stats_signal;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    // kill -USR2 <pid>: binary upgrade, see BinaryUpgrade.cpp
+    sa.sa_handler = handle_upgrade_signal;
+    sigaction(SIGUSR2, &sa, NULL);
+
+    // kill -QUIT <pid>: graceful stop (also sent by the upgraded process)
+    sa.sa_handler = handle_graceful_signal;
+    sigaction(SIGQUIT, &sa, NULL);
+
+    // A peer closing its socket (or a CGI closing its stdin) must turn into
+    // an EPIPE error instead of killing the process
+    std::signal(SIGPIPE, SIG_IGN);
 }
 
 /*Following functions have to be integrated with http response mechanism and logging*/
@@ -0,0 +1,148 @@
+#include "TimerWheel.hpp"
+#include <time.h>
+
+// Ticks covered by the root plus each level above it
+#define WHEEL_SPAN(level) ((uint64_t)1 << (ROOT_BITS + (level) * LEVEL_BITS))
+#define WHEEL_MAX_DELAY (WHEEL_SPAN(LEVELS) - 1)
+
+TimerWheel::TimerWheel() : _nowMs(0), _currentTick(0), _count(0)
+{
+    for (size_t i = 0; i < ROOT_SIZE; ++i)
+        _root[i].prev = _root[i].next = &_root[i];
+    for (size_t l = 0; l < LEVELS; ++l)
+        for (size_t i = 0; i < LEVEL_SIZE; ++i)
+            _levels[l][i].prev = _levels[l][i].next = &_levels[l][i];
+    updateClock();
+    _currentTick = _nowMs / TICK_MS;
+}
+
+void TimerWheel::updateClock()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    _nowMs = (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+void TimerWheel::link(Timer &head, Timer &t)
+{
+    t.prev = head.prev;
+    t.next = &head;
+    head.prev->next = &t;
+    head.prev = &t;
+}
+
+void TimerWheel::unlink(Timer &t)
+{
+    t.prev->next = t.next;
+    t.next->prev = t.prev;
+    t.prev = t.next = NULL;
+}
+
+// Place a timer in the slot matching its distance from the current tick
+void TimerWheel::insert(Timer &t)
+{
+    if (t.expires < _currentTick)
+    {
+        // Already due: fire on the next tick processed
+        link(_root[_currentTick & (ROOT_SIZE - 1)], t);
+        return;
+    }
+    uint64_t delta = t.expires - _currentTick;
+    if (delta < WHEEL_SPAN(0))
+    {
+        link(_root[t.expires & (ROOT_SIZE - 1)], t);
+        return;
+    }
+    if (delta > WHEEL_MAX_DELAY)
+        t.expires = _currentTick + WHEEL_MAX_DELAY;
+    for (int l = 0; l < LEVELS; ++l)
+    {
+        if (delta < WHEEL_SPAN(l + 1) || l == LEVELS - 1)
+        {
+            size_t shift = ROOT_BITS + l * LEVEL_BITS;
+            link(_levels[l][(t.expires >> shift) & (LEVEL_SIZE - 1)], t);
+            return;
+        }
+    }
+}
+
+void TimerWheel::arm(Timer &t, uint64_t delayMs)
+{
+    if (t.armed())
+        unlink(t);
+    else
+        ++_count;
+    // Round up so a timer never fires early
+    t.expires = (_nowMs + delayMs + TICK_MS - 1) / TICK_MS;
+    insert(t);
+}
+
+void TimerWheel::cancel(Timer &t)
+{
+    if (!t.armed())
+        return;
+    unlink(t);
+    --_count;
+}
+
+// Redistribute one slot of a coarser level over the levels below it
+void TimerWheel::cascade(int level, size_t index)
+{
+    Timer &head = _levels[level][index];
+    Timer *t = head.next;
+    head.prev = head.next = &head;
+    while (t != &head)
+    {
+        Timer *next = t->next;
+        insert(*t);
+        t = next;
+    }
+}
+
+void TimerWheel::expire(std::vector<Timer *> &out)
+{
+    uint64_t target = _nowMs / TICK_MS;
+    if (_count == 0)
+    {
+        // Nothing to cascade either: just move the wheel forward
+        if (_currentTick <= target)
+            _currentTick = target + 1;
+        return;
+    }
+    while (_currentTick <= target)
+    {
+        size_t index = _currentTick & (ROOT_SIZE - 1);
+        // Refill the root from the level above each time it wraps, and so on
+        for (int l = 0; index == 0 && l < LEVELS; ++l)
+        {
+            index = (_currentTick >> (ROOT_BITS + l * LEVEL_BITS)) & (LEVEL_SIZE - 1);
+            cascade(l, index);
+        }
+
+        Timer &head = _root[_currentTick & (ROOT_SIZE - 1)];
+        while (head.next != &head)
+        {
+            Timer *t = head.next;
+            unlink(*t);
+            --_count;
+            out.push_back(t);
+        }
+        ++_currentTick;
+    }
+}
+
+int TimerWheel::nextTimeoutMs(int maxMs) const
+{
+    if (_count == 0)
+        return maxMs;
+    for (uint64_t tick = _currentTick; tick < _currentTick + ROOT_SIZE; ++tick)
+    {
+        int64_t ms = (int64_t)(tick * TICK_MS) - (int64_t)_nowMs;
+        if (ms >= maxMs)
+            break;
+        // Wake up at a cascade boundary, too: timers may move into the root
+        if ((tick & (ROOT_SIZE - 1)) == 0 || _root[tick & (ROOT_SIZE - 1)].next != &_root[tick & (ROOT_SIZE - 1)])
+            return ms < 0 ? 0 : (int)ms;
+    }
+    return maxMs;
+}
@@ -0,0 +1,188 @@
+#include "Common.hpp"
+#include <sys/wait.h>
+
+/* Master/worker process model (worker_processes > 1).
+   - The master only supervises: it forks the workers, respawns the ones that
+     die and forwards SIGTERM/SIGINT to them on shutdown
+   - SIGQUIT is forwarded as well (graceful stop); the master stops
+     respawning and exits once the last worker has drained
+   - SIGUSR2 on the master starts the new binary (see BinaryUpgrade.cpp)
+   - Every worker binds its own SO_REUSEPORT listening sockets, so the kernel
+     spreads new connections across the workers' accept queues
+*/
+
+// A worker that dies sooner than this after being forked (e.g. bind() failed)
+// is not respawned, otherwise a broken setup would fork in a tight loop.
+#define WORKER_MIN_UPTIME 1
+
+static void logWorkerExit(size_t slot, pid_t pid, int status)
+{
+    std::cerr << "Worker " << slot << " (pid " << pid << ") ";
+    if (WIFSIGNALED(status))
+        std::cerr << "killed by signal " << WTERMSIG(status) << std::endl;
+    else
+        std::cerr << "exited with status " << WEXITSTATUS(status) << std::endl;
+}
+
+int HttpServer::runWorker(size_t workerIndex)
+{
+    // Only the first worker reports the listening sockets
+    bool verbose = (workerIndex == 0);
+    if (!openServerSockets(_workerProcesses > 1, verbose))
+        return 1;
+    if (verbose)
+        printStartupMessage();
+    // The master does this itself once all workers are forked
+    if (_workerProcesses == 1)
+        notifyUpgradeParent();
+
+    // Call the aligned accept loop
+    int result = runMultiServerAcceptLoop(_serverSockets);
+
+    // Cleanup
+    for (size_t i = 0; i < _serverSockets.size(); ++i)
+    {
+        if (_serverSockets[i].socket_fd >= 0) // -1 after a graceful stop
+            close(_serverSockets[i].socket_fd);
+    }
+    _serverSockets.clear();
+    return result;
+}
+
+// Returns in the master once every worker is gone. Forked workers return from
+// here as well (with the result of runWorker()), so they unwind through main().
+int HttpServer::runMaster()
+{
+    std::vector<pid_t> pids(_workerProcesses, -1);
+    std::vector<time_t> started(_workerProcesses, 0);
+    size_t alive = 0;
+
+    std::cout << "Master process " << getpid() << " starting "
+              << _workerProcesses << " worker processes" << std::endl;
+
+    for (size_t slot = 0; slot < _workerProcesses && !g_stop; ++slot)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+            return runWorker(slot);
+        if (pid < 0)
+        {
+            std::cerr << "fork() failed for worker " << slot << std::endl;
+            g_stop = 1;
+            break;
+        }
+        pids[slot] = pid;
+        started[slot] = time(NULL);
+        ++alive;
+    }
+
+    if (!g_stop)
+        notifyUpgradeParent();
+
+    bool failed = false;
+    bool draining = false;
+    sig_atomic_t statsSeen = g_statsRequest;
+    sig_atomic_t upgradeSeen = g_upgradeRequest;
+    while (!g_stop && alive > 0)
+    {
+        int status = 0;
+        // SIGTERM/SIGINT are installed without SA_RESTART, so a stop signal
+        // interrupts this wait and the loop condition is re-checked.
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            if (errno != EINTR)
+                break;
+            // SIGUSR1 on the master: every worker reports its counters
+            if (statsSeen != g_statsRequest)
+            {
+                statsSeen = g_statsRequest;
+                for (size_t slot = 0; slot < pids.size(); ++slot)
+                {
+                    if (pids[slot] > 0)
+                        kill(pids[slot], SIGUSR1);
+                }
+            }
+            if (upgradeSeen != g_upgradeRequest)
+            {
+                upgradeSeen = g_upgradeRequest;
+                if (!draining)
+                    spawnUpgrade();
+            }
+            // SIGQUIT: every worker drains on its own, nothing is respawned
+            if (g_graceful && !draining)
+            {
+                draining = true;
+                for (size_t slot = 0; slot < pids.size(); ++slot)
+                {
+                    if (pids[slot] > 0)
+                        kill(pids[slot], SIGQUIT);
+                }
+            }
+            continue;
+        }
+
+        size_t slot = 0;
+        while (slot < pids.size() && pids[slot] != pid)
+            ++slot;
+        if (slot == pids.size())
+            continue; // Not one of our workers
+        pids[slot] = -1;
+        --alive;
+        logWorkerExit(slot, pid, status);
+        if (g_stop)
+            break;
+        if (draining)
+            continue;
+
+        if (time(NULL) - started[slot] < WORKER_MIN_UPTIME)
+        {
+            std::cerr << "Worker " << slot << " died right after start, not respawning" << std::endl;
+            failed = true;
+            continue;
+        }
+
+        pid = fork();
+        if (pid == 0)
+            return runWorker(slot);
+        if (pid < 0)
+        {
+            std::cerr << "fork() failed while respawning worker " << slot << std::endl;
+            failed = true;
+            continue;
+        }
+        pids[slot] = pid;
+        started[slot] = time(NULL);
+        ++alive;
+        DEBUG_PRINT("Respawned worker " << slot << " (pid " << pid << ")");
+    }
+
+    // Forward the shutdown to the remaining workers and reap them
+    for (size_t slot = 0; slot < pids.size(); ++slot)
+    {
+        if (pids[slot] > 0)
+            kill(pids[slot], SIGTERM);
+    }
+    while (alive > 0)
+    {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (size_t slot = 0; slot < pids.size(); ++slot)
+        {
+            if (pids[slot] == pid)
+            {
+                pids[slot] = -1;
+                --alive;
+            }
+        }
+    }
+
+    DEBUG_PRINT("Master process shutting down...");
+    return (failed && !g_stop) ? 1 : 0;
+}